@@ -0,0 +1,67 @@
+#include "bench.h"
+
+#include "../src/world/chunkmanager.h"
+#include "../src/world/chunkmesher.h"
+
+// Allocations made by streaming and meshing. The first walk fills the chunk table,
+// walking back again runs on recycled chunks and block buffers
+BENCHMARK(allocations)
+{
+    ChunkManager manager;
+    Bench::loadWorld(manager, 4, 1);
+
+    auto walk = [&](int from, int to)
+    {
+        const size_t before = Bench::getAllocations();
+        const size_t reused = manager.table.getReused();
+        const int step = from < to ? 32 : -32;
+
+        int chunks = 0;
+        for (int x = from; x != to + step; x += step)
+        {
+            const size_t allocated = manager.table.getAllocated();
+            manager.Update({ x, 60, 0 });
+            chunks += (int)(manager.table.getAllocated() - allocated);
+        }
+        chunks += (int)(manager.table.getReused() - reused);
+
+        const size_t count = Bench::getAllocations() - before;
+        printf("  %4d chunks loaded, %7zu allocations, %6.1f per chunk\n", chunks, count, (double)count / chunks);
+    };
+
+    printf("  first walk, no free chunks to recycle\n");
+    walk(0, 32 * 16);
+    printf("  walking back, recycled chunks\n");
+    walk(32 * 16, 0);
+    printf("  chunk table: %zu chunks allocated, %zu reused, %zu free\n",
+        manager.table.getAllocated(), manager.table.getReused(), manager.table.getFreeCount());
+
+    // The mesher reuses the buffers of the MeshData it's given
+    std::vector<Chunk*> chunks;
+    for (auto chunk : manager.chunks)
+        chunks.push_back(chunk);
+
+    ChunkSnapshot snapshot;
+    MeshData reused;
+    for (int pass = 0; pass < 2; pass++)
+    {
+        const size_t before = Bench::getAllocations();
+        for (Chunk* chunk : chunks)
+        {
+            chunk->takeSnapshot(snapshot);
+            if (pass == 0)
+            {
+                MeshData fresh;
+                ChunkMesher::build(snapshot, Bench::ATLAS_TILES, fresh);
+                Bench::use(fresh.verticies.size());
+            }
+            else
+            {
+                ChunkMesher::build(snapshot, Bench::ATLAS_TILES, reused);
+                Bench::use(reused.verticies.size());
+            }
+        }
+        const size_t count = Bench::getAllocations() - before;
+        printf("  mesh %s MeshData: %.1f allocations per chunk\n", pass == 0 ? "into a new" : "into a reused", (double)count / chunks.size());
+    }
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+class ChunkManager;
+
+/*
+    Benchmarks
+    ----------
+    Every BENCHMARK() registers itself with the runner in main.cpp. "make bench" runs
+    all of them, "make bench ARGS=name" only the ones whose name contains name. Like
+    the tests they only link the world code and run without a window or GL context,
+    so nothing that needs the GPU (uploads, draw calls) is measured.
+
+    Numbers depend on the machine, only compare runs made on the same one.
+*/
+namespace Bench
+{
+    // resources/textures/textureAtlas.png is 8x8 tiles
+    const int ATLAS_TILES = 8;
+
+    struct Case
+    {
+        const char* name;
+        void      (*run)();
+    };
+
+    std::vector<Case>& getCases();
+
+    struct Register
+    {
+        Register(const char* name, void (*run)()) { getCases().push_back({ name, run }); }
+    };
+
+    // Calls fn until at least seconds passed, returns the average seconds per call
+    template<typename F>
+    double time(F&& fn, double seconds = 0.5)
+    {
+        using Clock = std::chrono::steady_clock;
+
+        int calls = 0;
+        const Clock::time_point start = Clock::now();
+        double elapsed = 0.0;
+        do
+        {
+            fn();
+            calls++;
+            elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+        } while (elapsed < seconds);
+
+        return elapsed / calls;
+    }
+
+    // Streams in the chunks in radius (and height) chunks around the origin with a fixed seed
+    void loadWorld(ChunkManager& manager, int radius = 3, int height = 1);
+
+    // Keeps the compiler from dropping work whose result is never used
+    void use(size_t value);
+
+    // Calls to operator new since the start of the program
+    size_t getAllocations();
+};
+
+#define BENCHMARK(name) \
+    static void bench_##name(); \
+    static Bench::Register register_##name(#name, bench_##name); \
+    static void bench_##name()
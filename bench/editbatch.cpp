@@ -0,0 +1,40 @@
+#include "bench.h"
+
+#include "../src/world/chunkmanager.h"
+#include "../src/world/editbatch.h"
+
+// A 64^3 fill block by block through setBlockGlobal() and as one EditBatch. Both write the
+// journal and queue the same chunks for a remesh, meshes aren't built without a GL context
+BENCHMARK(editbatch)
+{
+    ChunkManager manager;
+    Bench::loadWorld(manager);
+
+    const glm::ivec3 min(-32, 0, -32), max(32, 64, 32);
+    const int blocks = 64 * 64 * 64;
+
+    // Every run alternates the block so each one changes all of them
+    int run = 0;
+    double perBlock = Bench::time([&]()
+    {
+        const int block = (run++ & 1) ? Blocks::STONE : Blocks::PLANKS;
+        for (int x = min.x; x < max.x; x++)
+            for (int y = min.y; y < max.y; y++)
+                for (int z = min.z; z < max.z; z++)
+                    manager.setBlockGlobal(x, y, z, block);
+        manager.Update({ 0, 60, 0 });
+    }, 2.0);
+
+    double batched = Bench::time([&]()
+    {
+        const int block = (run++ & 1) ? Blocks::STONE : Blocks::PLANKS;
+        {
+            EditBatch batch(manager);
+            batch.fillBox(min, max, block);
+        }
+        manager.Update({ 0, 60, 0 });
+    }, 2.0);
+
+    printf("  64^3 fill: setBlockGlobal %.1f ms, EditBatch %.1f ms (%.1f M blocks/s)\n",
+        perBlock * 1000.0, batched * 1000.0, blocks / batched / 1e6);
+}
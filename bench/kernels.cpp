@@ -0,0 +1,85 @@
+#include "bench.h"
+
+#include "../src/world/chunkkernels.h"
+#include "../src/world/chunkmanager.h"
+#include "../src/world/chunkmesher.h"
+
+// Face masks of every section with the generic loop and the kernel of every supported isa,
+// then whole chunks meshed with each of them
+BENCHMARK(kernels)
+{
+    ChunkManager manager;
+    Bench::loadWorld(manager);
+
+    // Snapshots are taken up front, only the face masks are timed
+    std::vector<ChunkSnapshot> snapshots;
+    const int height = (int)manager.chunkSize.y;
+    for (auto chunk : manager.chunks)
+        for (int y = 0; y < height; y += Chunk::SECTION_HEIGHT)
+        {
+            snapshots.emplace_back();
+            chunk->takeSnapshot(snapshots.back(), y, std::min(y + Chunk::SECTION_HEIGHT, height));
+        }
+
+    const glm::ivec3 size = snapshots[0].size;
+    std::vector<uint8_t> masks(size.x * size.y * size.z);
+    const double blocks = (double)masks.size() * snapshots.size();
+
+    double seconds = Bench::time([&]()
+    {
+        for (const ChunkSnapshot& snapshot : snapshots)
+            ChunkKernels::faceMasks(size, snapshot.blocks.data(), masks.data());
+        Bench::use(masks[0]);
+    });
+    printf("  %-7s %7.1f Mblocks/s\n", "generic", blocks / seconds / 1e6);
+
+    for (ChunkKernels::Isa kernelIsa : { ChunkKernels::Isa::SCALAR, ChunkKernels::Isa::AVX2 })
+    {
+        ChunkKernels::FaceMaskKernel kernel = ChunkKernels::getFaceMaskKernel(size, kernelIsa);
+        if (kernel == nullptr)
+            continue;
+
+        seconds = Bench::time([&]()
+        {
+            for (const ChunkSnapshot& snapshot : snapshots)
+                kernel(snapshot.blocks.data(), snapshot.rows.data(), masks.data());
+            Bench::use(masks[0]);
+        });
+        printf("  %-7s %7.1f Mblocks/s\n", kernelIsa == ChunkKernels::Isa::AVX2 ? "avx2" : "scalar", blocks / seconds / 1e6);
+    }
+
+    // ChunkMesher::build() of whole chunks, snapshots without rows take the generic loop
+    std::vector<ChunkSnapshot> whole(manager.chunks.size());
+    size_t i = 0;
+    for (auto chunk : manager.chunks)
+        chunk->takeSnapshot(whole[i++]);
+
+    printf("  meshing %d x %d x %d chunks\n", whole[0].size.x, whole[0].size.y, whole[0].size.z);
+    MeshData mesh;
+    auto meshAll = [&]()
+    {
+        return Bench::time([&]()
+        {
+            for (const ChunkSnapshot& snapshot : whole)
+                ChunkMesher::build(snapshot, Bench::ATLAS_TILES, mesh);
+            Bench::use(mesh.getQuadCount());
+        });
+    };
+
+    const ChunkKernels::Isa isa = ChunkKernels::getIsa();
+    for (ChunkKernels::Isa kernelIsa : { ChunkKernels::Isa::SCALAR, ChunkKernels::Isa::AVX2 })
+    {
+        if (!ChunkKernels::isSupported(kernelIsa))
+            continue;
+
+        ChunkKernels::setIsa(kernelIsa);
+        seconds = meshAll();
+        printf("  %-7s %7.0f chunks/s\n", kernelIsa == ChunkKernels::Isa::AVX2 ? "avx2" : "scalar", whole.size() / seconds);
+    }
+    ChunkKernels::setIsa(isa);
+
+    for (ChunkSnapshot& snapshot : whole)
+        snapshot.rows.clear();
+    seconds = meshAll();
+    printf("  %-7s %7.0f chunks/s\n", "generic", whole.size() / seconds);
+}
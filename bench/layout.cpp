@@ -0,0 +1,98 @@
+#include "bench.h"
+
+#include <unordered_map>
+#include "../src/world/chunkmanager.h"
+#include "../src/world/chunkmesher.h"
+
+namespace
+{
+    // The chunks blocks stored in the given layout, like a chunk built with that layout would have them
+    BlockSnapshot relayout(Chunk* chunk, ChunkLayout::Type type)
+    {
+        const ChunkLayout& layout = ChunkLayout::get(chunk->getLayout().getSize(), type);
+        auto storage = std::make_shared<BlockStorage>(layout.getCount(), Blocks::AIR);
+        for (int i = 0; i < layout.getCount(); i++)
+        {
+            glm::ivec3 p = layout.position(i);
+            storage->set(i, (uint16_t)chunk->getBlockLocal(p.x, p.y, p.z));
+        }
+        storage->compact();
+
+        auto occupancy = std::make_shared<OccupancyMask>(layout.getSize());
+        occupancy->build(*storage, layout);
+
+        BlockSnapshot blocks;
+        blocks.storage = storage;
+        blocks.occupancy = occupancy;
+        blocks.layout = &layout;
+        return blocks;
+    }
+};
+
+// Meshing (snapshot + mesh of every section) and neighbour queries on the same chunks
+// stored in the linear and the Morton layout. The chunks themselves use ChunkLayout::DEFAULT,
+// build with -DCHUNK_MORTON_LAYOUT to switch
+BENCHMARK(layout)
+{
+    ChunkManager manager;
+    Bench::loadWorld(manager);
+
+    std::vector<Chunk*> chunks;
+    for (auto chunk : manager.chunks)
+        chunks.push_back(chunk);
+
+    const glm::ivec3 size = glm::ivec3(manager.chunkSize);
+    const int sectionHeight = chunks[0]->getSectionHeight();
+
+    printf("  chunks use the %s layout\n", ChunkLayout::DEFAULT == ChunkLayout::MORTON ? "Morton" : "linear");
+    for (ChunkLayout::Type type : { ChunkLayout::LINEAR, ChunkLayout::MORTON })
+    {
+        std::unordered_map<Chunk*, BlockSnapshot> blocks;
+        for (Chunk* chunk : chunks)
+            blocks[chunk] = relayout(chunk, type);
+
+        ChunkSnapshot snapshot;
+        MeshData mesh;
+        double meshing = Bench::time([&]()
+        {
+            for (Chunk* chunk : chunks)
+            {
+                BlockSnapshot neighbours[6];
+                for (int i = 0; i < 6; i++)
+                {
+                    Chunk* neighbour = chunk->getNeighbour((NEIGHBOUR)i);
+                    if (neighbour != nullptr)
+                        neighbours[i] = blocks[neighbour];
+                }
+
+                for (int y = 0; y < size.y; y += sectionHeight)
+                {
+                    Chunk::buildSnapshot(blocks[chunk], neighbours, snapshot, y, std::min(y + sectionHeight, size.y));
+                    ChunkMesher::build(snapshot, Bench::ATLAS_TILES, mesh);
+                    Bench::use(mesh.verticies.size());
+                }
+            }
+        });
+
+        // Counts the solid neighbours of every block, what a lighting or physics pass would do
+        double queries = Bench::time([&]()
+        {
+            size_t solid = 0;
+            for (Chunk* chunk : chunks)
+            {
+                const BlockSnapshot& chunkBlocks = blocks[chunk];
+                for (int x = 1; x < size.x - 1; x++)
+                    for (int y = 1; y < size.y - 1; y++)
+                        for (int z = 1; z < size.z - 1; z++)
+                            solid += (chunkBlocks.get(x - 1, y, z) != Blocks::AIR) + (chunkBlocks.get(x + 1, y, z) != Blocks::AIR)
+                                   + (chunkBlocks.get(x, y - 1, z) != Blocks::AIR) + (chunkBlocks.get(x, y + 1, z) != Blocks::AIR)
+                                   + (chunkBlocks.get(x, y, z - 1) != Blocks::AIR) + (chunkBlocks.get(x, y, z + 1) != Blocks::AIR);
+            }
+            Bench::use(solid);
+        });
+
+        const double inner = (double)(size.x - 2) * (size.y - 2) * (size.z - 2) * 6 * chunks.size();
+        printf("  %-6s mesh %.0f chunks/s, neighbour queries %.1f M/s\n",
+            type == ChunkLayout::MORTON ? "morton" : "linear", chunks.size() / meshing, inner / queries / 1e6);
+    }
+}
@@ -0,0 +1,70 @@
+#include "bench.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include "../src/world/chunkmanager.h"
+
+namespace
+{
+    volatile size_t sink = 0;
+    size_t allocations = 0;
+}
+
+// Counts every allocation, the benchmarks are single threaded
+void* operator new(size_t size)
+{
+    allocations++;
+    void* p = malloc(size != 0 ? size : 1);
+    if (p == nullptr)
+        throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void* p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    free(p);
+}
+
+std::vector<Bench::Case>& Bench::getCases()
+{
+    static std::vector<Case> cases;
+    return cases;
+}
+
+void Bench::loadWorld(ChunkManager& manager, int radius, int height)
+{
+    manager.setTerrain(32, 96, 77);
+    manager.setStreamingRadius(radius, height);
+    manager.setChunksPerFrame(100000);
+    manager.Update({ 0, 60, 0 });
+}
+
+void Bench::use(size_t value)
+{
+    sink = sink + value;
+}
+
+size_t Bench::getAllocations()
+{
+    return allocations;
+}
+
+int main(int argc, char* argv[])
+{
+    for (const Bench::Case& bench : Bench::getCases())
+    {
+        if (argc > 1 && strstr(bench.name, argv[1]) == nullptr)
+            continue;
+
+        printf("%s\n", bench.name);
+        bench.run();
+        printf("\n");
+    }
+    return 0;
+}
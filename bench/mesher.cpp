@@ -0,0 +1,43 @@
+#include "bench.h"
+
+#include "../src/world/chunkmanager.h"
+#include "../src/world/chunkmesher.h"
+
+// Naive and greedy meshes of the generated terrain, section by section like Chunk::generateMesh()
+BENCHMARK(mesher)
+{
+    ChunkManager manager;
+    Bench::loadWorld(manager);
+
+    std::vector<Chunk*> chunks;
+    for (auto chunk : manager.chunks)
+        chunks.push_back(chunk);
+
+    const int height = (int)manager.chunkSize.y;
+    const int sectionHeight = chunks[0]->getSectionHeight();
+
+    for (ChunkMesher::Mode mode : { ChunkMesher::Mode::NAIVE, ChunkMesher::Mode::GREEDY })
+    {
+        ChunkSnapshot snapshot;
+        MeshData mesh;
+        size_t quads = 0;
+
+        double seconds = Bench::time([&]()
+        {
+            quads = 0;
+            for (Chunk* chunk : chunks)
+                for (int y = 0; y < height; y += sectionHeight)
+                {
+                    chunk->takeSnapshot(snapshot, y, std::min(y + sectionHeight, height));
+                    ChunkMesher::build(snapshot, Bench::ATLAS_TILES, mesh, mode);
+                    quads += mesh.getQuadCount();
+                }
+            Bench::use(quads);
+        });
+
+        // Indices come from the shared quad index buffer, only the verticies are uploaded per chunk
+        printf("  %-6s %7zu quads, %7zu verticies, %6.2f MB upload, %.1f ms for %zu chunks\n",
+            mode == ChunkMesher::Mode::NAIVE ? "naive" : "greedy", quads, quads * 4,
+            quads * 4 * sizeof(GLuint) / (1024.0 * 1024.0), seconds * 1000.0, chunks.size());
+    }
+}
@@ -0,0 +1,52 @@
+#include "bench.h"
+
+#include "../src/world/chunkmanager.h"
+
+// Counting the visible faces of every chunk from the occupancy bits against testing
+// the six neighbours of every block
+BENCHMARK(occupancy)
+{
+    ChunkManager manager;
+    Bench::loadWorld(manager);
+
+    std::vector<Chunk*> chunks;
+    for (auto chunk : manager.chunks)
+        chunks.push_back(chunk);
+
+    const glm::ivec3 size(manager.chunkSize);
+    size_t faces = 0;
+
+    double bits = Bench::time([&]()
+    {
+        faces = 0;
+        for (Chunk* chunk : chunks)
+            faces += chunk->getOccupancy().countFaces();
+        Bench::use(faces);
+    });
+
+    size_t checked = 0;
+    double perBlock = Bench::time([&]()
+    {
+        checked = 0;
+        for (Chunk* chunk : chunks)
+        {
+            auto solid = [&](int x, int y, int z)
+            {
+                if (x < 0 || y < 0 || z < 0 || x >= size.x || y >= size.y || z >= size.z)
+                    return false;
+                return chunk->getBlockUnchecked(x, y, z) != Blocks::AIR;
+            };
+
+            for (int x = 0; x < size.x; x++)
+                for (int y = 0; y < size.y; y++)
+                    for (int z = 0; z < size.z; z++)
+                        if (solid(x, y, z))
+                            checked += !solid(x - 1, y, z) + !solid(x + 1, y, z) + !solid(x, y - 1, z)
+                                     + !solid(x, y + 1, z) + !solid(x, y, z - 1) + !solid(x, y, z + 1);
+        }
+        Bench::use(checked);
+    });
+
+    printf("  %zu faces in %zu chunks%s\n", faces, chunks.size(), faces == checked ? "" : ", COUNTS DIFFER");
+    printf("  countFaces %.3f ms, per block %.3f ms (%.1fx)\n", bits * 1000.0, perBlock * 1000.0, perBlock / bits);
+}
@@ -0,0 +1,78 @@
+#include "bench.h"
+
+#include "../src/world/chunkmanager.h"
+#include "../src/world/chunkmesher.h"
+
+// Time from a single block edit to its new mesh data, remeshing the whole chunk like before
+// the mesh was split into sections and remeshing only the sections the edit touches.
+// Edits are inside of the chunks so no neighbour needs a remesh, the upload isn't measured
+BENCHMARK(sections)
+{
+    ChunkManager manager;
+    Bench::loadWorld(manager);
+
+    struct Edit
+    {
+        Chunk*     chunk;
+        glm::ivec3 local;
+    };
+
+    std::vector<Edit> edits;
+    int i = 0;
+    for (auto chunk : manager.chunks)
+    {
+        const glm::ivec3 size = glm::ivec3(manager.chunkSize);
+        for (int n = 0; n < 4; n++, i++)
+            edits.push_back({ chunk, glm::ivec3(1 + (i * 7) % (size.x - 2), 1 + (i * 13) % (size.y - 2), 1 + (i * 5) % (size.z - 2)) });
+    }
+
+    // Every edit flips the block between AIR and STONE
+    auto edit = [](const Edit& e)
+    {
+        const int block = e.chunk->getBlockLocal(e.local.x, e.local.y, e.local.z);
+        e.chunk->setBlockLocal(e.local.x, e.local.y, e.local.z, block == Blocks::AIR ? Blocks::STONE : Blocks::AIR);
+    };
+
+    ChunkSnapshot snapshot;
+    MeshData mesh;
+
+    double whole = Bench::time([&]()
+    {
+        for (const Edit& e : edits)
+        {
+            edit(e);
+            e.chunk->takeSnapshot(snapshot);
+            ChunkMesher::build(snapshot, Bench::ATLAS_TILES, mesh);
+        }
+        Bench::use(mesh.getQuadCount());
+    });
+
+    size_t sections = 0;
+    double split = Bench::time([&]()
+    {
+        sections = 0;
+        for (const Edit& e : edits)
+        {
+            edit(e);
+
+            // Same rows as ChunkManager::markDirty(), the blocks around the edit
+            const int height = e.chunk->getSectionHeight();
+            const int rows = (int)manager.chunkSize.y;
+            const uint32_t dirty = e.chunk->getSections(e.local.y - 1, e.local.y + 2);
+            for (int section = 0; section < e.chunk->getSectionCount(); section++)
+            {
+                if (!(dirty & (1u << section)))
+                    continue;
+
+                e.chunk->takeSnapshot(snapshot, section * height, std::min((section + 1) * height, rows));
+                ChunkMesher::build(snapshot, Bench::ATLAS_TILES, mesh);
+                sections++;
+            }
+        }
+        Bench::use(mesh.getQuadCount());
+    });
+
+    printf("  whole chunk %7.1f us per edit\n", whole / edits.size() * 1e6);
+    printf("  sections    %7.1f us per edit, %.2f sections of %d rows\n",
+        split / edits.size() * 1e6, (double)sections / edits.size(), edits[0].chunk->getSectionHeight());
+}
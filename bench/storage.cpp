@@ -0,0 +1,129 @@
+#include "bench.h"
+
+#include <cstring>
+#include <unordered_map>
+#include "../src/world/chunkmanager.h"
+#include "../src/world/chunkmesher.h"
+
+namespace
+{
+    // The layout before palette storage, one plain id per block
+    struct FlatChunk
+    {
+        glm::ivec3            size;
+        std::vector<uint16_t> blocks;
+
+        uint16_t get(int x, int y, int z) const { return blocks[(x * size.y + y) * size.z + z]; }
+    };
+
+    // Same snapshot as Chunk::takeSnapshot() but copied from flat chunks
+    void flatSnapshot(const FlatChunk& chunk, const FlatChunk* neighbours[6], ChunkSnapshot& out)
+    {
+        const glm::ivec3 size = chunk.size;
+        out.resize(size);
+        for (int x = 0; x < size.x; x++)
+            for (int y = 0; y < size.y; y++)
+                memcpy(&out.blocks[out.index(x, y, 0)], &chunk.blocks[(x * size.y + y) * size.z], size.z * sizeof(uint16_t));
+
+        const FlatChunk* n;
+        if ((n = neighbours[EAST]) != nullptr)
+            for (int y = 0; y < size.y; y++)
+                for (int z = 0; z < size.z; z++)
+                    out.blocks[out.index(-1, y, z)] = n->get(size.x - 1, y, z);
+        if ((n = neighbours[WEST]) != nullptr)
+            for (int y = 0; y < size.y; y++)
+                for (int z = 0; z < size.z; z++)
+                    out.blocks[out.index(size.x, y, z)] = n->get(0, y, z);
+        if ((n = neighbours[BELOW]) != nullptr)
+            for (int x = 0; x < size.x; x++)
+                for (int z = 0; z < size.z; z++)
+                    out.blocks[out.index(x, -1, z)] = n->get(x, size.y - 1, z);
+        if ((n = neighbours[ABOVE]) != nullptr)
+            for (int x = 0; x < size.x; x++)
+                for (int z = 0; z < size.z; z++)
+                    out.blocks[out.index(x, size.y, z)] = n->get(x, 0, z);
+        if ((n = neighbours[NORTH]) != nullptr)
+            for (int x = 0; x < size.x; x++)
+                for (int y = 0; y < size.y; y++)
+                    out.blocks[out.index(x, y, -1)] = n->get(x, y, size.z - 1);
+        if ((n = neighbours[SOUTH]) != nullptr)
+            for (int x = 0; x < size.x; x++)
+                for (int y = 0; y < size.y; y++)
+                    out.blocks[out.index(x, y, size.z)] = n->get(x, y, 0);
+    }
+};
+
+// Memory per chunk and the CPU part of Chunk::generateMesh() (snapshot + mesh) for
+// palette storage against a flat array with one id per block
+BENCHMARK(storage)
+{
+    ChunkManager manager;
+    Bench::loadWorld(manager);
+
+    std::vector<Chunk*> chunks;
+    std::unordered_map<Chunk*, FlatChunk> flat;
+    size_t paletteBytes = 0;
+    for (auto chunk : manager.chunks)
+    {
+        chunks.push_back(chunk);
+        paletteBytes += chunk->snapshotBlocks().storage->getMemoryUsage();
+
+        FlatChunk& copy = flat[chunk];
+        copy.size = glm::ivec3(manager.chunkSize);
+        copy.blocks.resize(copy.size.x * copy.size.y * copy.size.z);
+        for (int x = 0; x < copy.size.x; x++)
+            for (int y = 0; y < copy.size.y; y++)
+                for (int z = 0; z < copy.size.z; z++)
+                    copy.blocks[(x * copy.size.y + y) * copy.size.z + z] = (uint16_t)chunk->getBlockLocal(x, y, z);
+    }
+
+    const size_t blocks = flat.begin()->second.blocks.size();
+    printf("  %zu chunks of %zu blocks\n", chunks.size(), blocks);
+    printf("  memory per chunk: palette %zu B, flat 8-bit %zu B, flat 16-bit %zu B\n",
+        paletteBytes / chunks.size(), blocks, blocks * sizeof(uint16_t));
+
+    ChunkSnapshot snapshot;
+    MeshData mesh;
+    for (ChunkMesher::Mode mode : { ChunkMesher::Mode::NAIVE, ChunkMesher::Mode::GREEDY })
+    {
+        const char* name = mode == ChunkMesher::Mode::NAIVE ? "naive " : "greedy";
+
+        double palette = Bench::time([&]()
+        {
+            for (Chunk* chunk : chunks)
+            {
+                chunk->takeSnapshot(snapshot);
+                ChunkMesher::build(snapshot, Bench::ATLAS_TILES, mesh, mode);
+                Bench::use(mesh.verticies.size());
+            }
+        });
+
+        double plain = Bench::time([&]()
+        {
+            for (Chunk* chunk : chunks)
+            {
+                const FlatChunk* neighbours[6];
+                for (int i = 0; i < 6; i++)
+                {
+                    Chunk* neighbour = chunk->getNeighbour((NEIGHBOUR)i);
+                    neighbours[i] = neighbour != nullptr ? &flat[neighbour] : nullptr;
+                }
+                flatSnapshot(flat[chunk], neighbours, snapshot);
+                ChunkMesher::build(snapshot, Bench::ATLAS_TILES, mesh, mode);
+                Bench::use(mesh.verticies.size());
+            }
+        });
+
+        printf("  %s mesh: palette %.0f chunks/s, flat %.0f chunks/s\n", name, chunks.size() / palette, chunks.size() / plain);
+    }
+
+    double snapshots = Bench::time([&]()
+    {
+        for (Chunk* chunk : chunks)
+        {
+            chunk->takeSnapshot(snapshot);
+            Bench::use(snapshot.blocks[0]);
+        }
+    });
+    printf("  snapshot only: palette %.0f chunks/s\n", chunks.size() / snapshots);
+}
@@ -0,0 +1,61 @@
+#include "bench.h"
+
+#include "../src/world/chunkmanager.h"
+#include "../src/world/worldview.h"
+
+// Point reads along a ray and reads of a box through ChunkManager::getBlockGlobal()
+// and through a WorldView
+BENCHMARK(worldview)
+{
+    ChunkManager manager;
+    Bench::loadWorld(manager);
+
+    // A ray cast walks small steps, most reads stay in the chunk of the last one
+    const glm::vec3 start(-70.5f, 20.5f, -60.5f);
+    const glm::vec3 step = glm::normalize(glm::vec3(1.0f, 0.3f, 0.8f)) * 0.05f;
+    const int reads = 4000;
+
+    double global = Bench::time([&]()
+    {
+        size_t sum = 0;
+        glm::vec3 p = start;
+        for (int i = 0; i < reads; i++, p += step)
+            sum += manager.getBlockGlobal(p);
+        Bench::use(sum);
+    });
+
+    double view = Bench::time([&]()
+    {
+        WorldView world(manager);
+        size_t sum = 0;
+        glm::vec3 p = start;
+        for (int i = 0; i < reads; i++, p += step)
+            sum += world.getBlock(p);
+        Bench::use(sum);
+    });
+
+    printf("  ray reads:  getBlockGlobal %.1f M/s, WorldView %.1f M/s\n", reads / global / 1e6, reads / view / 1e6);
+
+    const glm::ivec3 min(-40, 0, -20), max(30, 50, 25);
+    const glm::ivec3 extent = max - min;
+    std::vector<int> blocks(extent.x * extent.y * extent.z);
+
+    double box = Bench::time([&]()
+    {
+        int i = 0;
+        for (int x = min.x; x < max.x; x++)
+            for (int y = min.y; y < max.y; y++)
+                for (int z = min.z; z < max.z; z++)
+                    blocks[i++] = manager.getBlockGlobal(x, y, z);
+        Bench::use(blocks[i / 2]);
+    });
+
+    double region = Bench::time([&]()
+    {
+        WorldView world(manager);
+        world.getRegion(min, max, blocks.data());
+        Bench::use(blocks[blocks.size() / 2]);
+    });
+
+    printf("  box reads:  getBlockGlobal %.1f M/s, getRegion %.1f M/s\n", blocks.size() / box / 1e6, blocks.size() / region / 1e6);
+}
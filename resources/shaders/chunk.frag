@@ -0,0 +1,22 @@
+#version 330
+in vec2 pass_texture;
+flat in vec2 pass_tile;
+
+out vec4 Frag_Colour;
+
+uniform sampler2D textureSampler;
+uniform float atlasTiles;
+
+void main(void)
+{
+	// Same inset by half a pixel as gl::TextureAtlas::getTextureCoords()
+	float tileSize = 1.0 / atlasTiles;
+	float pixel = 1.0 / float(textureSize(textureSampler, 0).x);
+	vec2 uv = pass_tile * tileSize + 0.5 * pixel + fract(pass_texture) * (tileSize - pixel);
+
+	vec4 texColor = texture(textureSampler, uv);
+	Frag_Colour = texColor;
+
+	if (Frag_Colour.a <= 0.1)
+		discard;
+}
\ No newline at end of file
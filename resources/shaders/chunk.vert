@@ -0,0 +1,36 @@
+#version 330
+in layout(location = 0) uint vertex;
+
+out vec2 pass_texture;
+flat out vec2 pass_tile;
+
+uniform mat4 MVPMatrix;
+uniform float atlasTiles;
+
+// Texture axes of every Cube::CubeFace (u, v, u direction, v direction),
+// must match the corners of Cube::getCubeFace()
+const ivec4 faceAxes[6] = ivec4[6](
+	ivec4(2, 0, -1,  1),	// TOP
+	ivec4(0, 2,  1, -1),	// BOTTOM
+	ivec4(2, 1,  1, -1),	// LEFT
+	ivec4(2, 1, -1, -1),	// RIGHT
+	ivec4(0, 1, -1, -1),	// BACK
+	ivec4(0, 1,  1, -1)		// FRONT
+);
+
+void main(void)
+{
+	// Vertex layout is described in chunkmesher.h
+	vec3 position = vec3(vertex & 0x7Fu, (vertex >> 7) & 0x1FFu, (vertex >> 16) & 0x7Fu);
+	uint face = (vertex >> 23) & 0x7u;
+	uint tile = vertex >> 26;
+
+	// The texture repeats once per block along both axes of the face
+	ivec4 axes = faceAxes[face];
+	pass_texture = vec2(position[axes.x] * axes.z, position[axes.y] * axes.w);
+
+	uint tilesPerRow = uint(atlasTiles);
+	pass_tile = vec2(tile % tilesPerRow, tile / tilesPerRow);
+
+	gl_Position = MVPMatrix * vec4(position, 1.0);
+}
\ No newline at end of file
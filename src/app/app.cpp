@@ -2,6 +2,7 @@
 
 #include <cstdio>
 #include <glad/glad.h>
+#include "../renderer/renderer.h"
 #include "../states/statemanager.h"
 
 Clock::Clock()
@@ -28,6 +29,8 @@ App::App()
 
 App::~App()
 {
+    // The states (and their chunk meshes) are gone already, StateManager was set up after us
+    Renderer::ReleaseQuadIndices();
     SDL_DestroyWindow(m_window);
     SDL_GL_DeleteContext(m_maincontext);
     SDL_Quit();
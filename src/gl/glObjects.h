@@ -86,8 +86,17 @@ namespace gl
         // stride is the size of each vertex, if 0 is given it takes thinks it's a packed array
         void setData(const std::vector<GLfloat>& data, GLsizeiptr sizeofData, int attributeID, int size, GLsizei stride = 0, const void * offset = 0, int DrawMode = GL_STATIC_DRAW);
         void setSubData(GLintptr offset, GLsizeiptr sizeofData, const std::vector<GLfloat>& data);
+        // Integer attributes, the shader reads them as uint or uvecN without converting them to floats
+        void setData(const std::vector<GLuint>& data, int attributeID, int size, int DrawMode = GL_STATIC_DRAW);
+        void setSubData(GLintptr offset, const std::vector<GLuint>& data);
+
+        // Resizes the buffer to sizeofData bytes, the old contents are lost
+        void allocate(GLsizeiptr sizeofData, int DrawMode = GL_STATIC_DRAW);
+        // Copies sizeofData bytes from source on the GPU, without reading them back
+        void copySubData(const VertexBufferObject& source, GLintptr readOffset, GLintptr writeOffset, GLsizeiptr sizeofData);
 
         void defineVertexAttribPointer(int attributeID, int size, GLsizei stride, const void * offset);
+        void defineIntegerAttribPointer(int attributeID, int size, GLsizei stride = 0, const void * offset = nullptr);
     };
 };
 
@@ -96,13 +105,17 @@ namespace gl
     struct ElementArrayBuffer
     {
         ElementArrayBuffer();
+        // Without generate the buffer is only created by the first setData()
+        explicit ElementArrayBuffer(bool generate);
         ~ElementArrayBuffer();
 
         void setData(const std::vector<GLuint>& indicies, int DrawMode = GL_STATIC_DRAW);
+        void setData(const std::vector<GLushort>& indicies, int DrawMode = GL_STATIC_DRAW);
         void setSubData(const std::vector<GLuint>& indicies);
 
         GLuint EBO  = -1;
         GLuint size =  0;
+        GLenum type = GL_UNSIGNED_INT;  // Type of the indicies, GL_UNSIGNED_SHORT for 16-bit ones
     };
 };
 
@@ -430,6 +443,40 @@ void gl::VertexBufferObject::setSubData(GLintptr offset, GLsizeiptr sizeofData,
     glLogCall(glBindBuffer(GL_ARRAY_BUFFER, 0));
 }
 
+void gl::VertexBufferObject::setData(const std::vector<GLuint>& data, int attributeID, int size, int DrawMode)
+{
+    glLogCall(glBindBuffer(GL_ARRAY_BUFFER, VBO));
+    glLogCall(glBufferData(GL_ARRAY_BUFFER, data.size() * sizeof(GLuint), data.data(), DrawMode));
+
+    glLogCall(glEnableVertexAttribArray(attributeID));
+    glLogCall(glVertexAttribIPointer(attributeID, size, GL_UNSIGNED_INT, 0, nullptr));
+
+    glLogCall(glBindBuffer(GL_ARRAY_BUFFER, 0));
+}
+
+void gl::VertexBufferObject::setSubData(GLintptr offset, const std::vector<GLuint>& data)
+{
+    glLogCall(glBindBuffer(GL_ARRAY_BUFFER, VBO));
+    glLogCall(glBufferSubData(GL_ARRAY_BUFFER, offset, data.size() * sizeof(GLuint), data.data()));
+    glLogCall(glBindBuffer(GL_ARRAY_BUFFER, 0));
+}
+
+void gl::VertexBufferObject::allocate(GLsizeiptr sizeofData, int DrawMode)
+{
+    glLogCall(glBindBuffer(GL_ARRAY_BUFFER, VBO));
+    glLogCall(glBufferData(GL_ARRAY_BUFFER, sizeofData, nullptr, DrawMode));
+    glLogCall(glBindBuffer(GL_ARRAY_BUFFER, 0));
+}
+
+void gl::VertexBufferObject::copySubData(const VertexBufferObject& source, GLintptr readOffset, GLintptr writeOffset, GLsizeiptr sizeofData)
+{
+    glLogCall(glBindBuffer(GL_COPY_READ_BUFFER, source.VBO));
+    glLogCall(glBindBuffer(GL_COPY_WRITE_BUFFER, VBO));
+    glLogCall(glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, readOffset, writeOffset, sizeofData));
+    glLogCall(glBindBuffer(GL_COPY_WRITE_BUFFER, 0));
+    glLogCall(glBindBuffer(GL_COPY_READ_BUFFER, 0));
+}
+
 void gl::VertexBufferObject::defineVertexAttribPointer(int attributeID, int size, GLsizei stride, const void * offset)
 {
     glLogCall(glBindBuffer(GL_ARRAY_BUFFER, VBO));
@@ -440,27 +487,66 @@ void gl::VertexBufferObject::defineVertexAttribPointer(int attributeID, int size
     glLogCall(glBindBuffer(GL_ARRAY_BUFFER, 0));
 }
 
+void gl::VertexBufferObject::defineIntegerAttribPointer(int attributeID, int size, GLsizei stride, const void * offset)
+{
+    glLogCall(glBindBuffer(GL_ARRAY_BUFFER, VBO));
+
+    glLogCall(glEnableVertexAttribArray(attributeID));
+    glLogCall(glVertexAttribIPointer(attributeID, size, GL_UNSIGNED_INT, stride, offset));
+
+    glLogCall(glBindBuffer(GL_ARRAY_BUFFER, 0));
+}
+
 /////////////////////////////////////////////////////////////////////////////
 
 //////////////////////////////
 //    EBO IMPLEMENTATION    //
 /////////////////////////////
 gl::ElementArrayBuffer::ElementArrayBuffer()
+    : ElementArrayBuffer(true)
 {
-    glLogCall(glGenBuffers(1, &EBO));
+}
+
+gl::ElementArrayBuffer::ElementArrayBuffer(bool generate)
+{
+    if (generate)
+    {
+        glLogCall(glGenBuffers(1, &EBO));
+    }
 }
 
 gl::ElementArrayBuffer::~ElementArrayBuffer()
 {
-    glLogCall(glDeleteBuffers(1, &EBO));
+    if (EBO != (GLuint)-1)
+    {
+        glLogCall(glDeleteBuffers(1, &EBO));
+    }
 }
 
 void gl::ElementArrayBuffer::setData(const std::vector<GLuint>& indicies, int DrawMode)
 {
+    if (EBO == (GLuint)-1)
+    {
+        glLogCall(glGenBuffers(1, &EBO));
+    }
     glLogCall(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO));
     glLogCall(glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(GLuint) * indicies.size(), indicies.data(), DrawMode));
 
     size = indicies.size();
+    type = GL_UNSIGNED_INT;
+}
+
+void gl::ElementArrayBuffer::setData(const std::vector<GLushort>& indicies, int DrawMode)
+{
+    if (EBO == (GLuint)-1)
+    {
+        glLogCall(glGenBuffers(1, &EBO));
+    }
+    glLogCall(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO));
+    glLogCall(glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(GLushort) * indicies.size(), indicies.data(), DrawMode));
+
+    size = indicies.size();
+    type = GL_UNSIGNED_SHORT;
 }
 
 void gl::ElementArrayBuffer::setSubData(const std::vector<GLuint>& indicies)
@@ -469,6 +555,7 @@ void gl::ElementArrayBuffer::setSubData(const std::vector<GLuint>& indicies)
     glLogCall(glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, sizeof(GLuint) * indicies.size(), indicies.data()));
 
     size = indicies.size();
+    type = GL_UNSIGNED_INT;
 }
 
 /////////////////////////////////////////////////////////////////////////////
@@ -1,6 +1,8 @@
 #include "renderer.h"
 #include "../util/entity.h"
 
+#include <algorithm>
+
 void Renderer::Render(gl::VertexArray & vao, gl::ElementArrayBuffer & ebo, gl::Texture & texture, gl::Material & material, GLenum mode)
 {
     material.shader->Bind();
@@ -12,7 +14,7 @@ void Renderer::Render(gl::VertexArray & vao, gl::ElementArrayBuffer & ebo, gl::T
 
     vao.Bind();
     gl::glClearErrors();
-    glDrawElements(mode, ebo.size, GL_UNSIGNED_INT, nullptr);
+    glDrawElements(mode, ebo.size, ebo.type, nullptr);
     gl::glCheckError(__FILE__, __LINE__);
     drawCalls++;
     vao.Unbind();
@@ -31,7 +33,7 @@ void Renderer::RenderEntity(Entity & entity, gl::Material & material, GLenum mod
 
     entity.VAO.Bind();
     gl::glClearErrors();
-    glDrawElements(mode, entity.EBO.size, GL_UNSIGNED_INT, nullptr);
+    glDrawElements(mode, entity.EBO.size, entity.EBO.type, nullptr);
     gl::glCheckError(__FILE__, __LINE__);
     drawCalls++;
     entity.VAO.Unbind();
@@ -45,7 +47,7 @@ void Renderer::RenderNoTexture(gl::VertexArray & vao, gl::ElementArrayBuffer & e
 
     vao.Bind();
     gl::glClearErrors();
-    glDrawElements(mode, ebo.size, GL_UNSIGNED_INT, nullptr);
+    glDrawElements(mode, ebo.size, ebo.type, nullptr);
     gl::glCheckError(__FILE__, __LINE__);
     drawCalls++;
     vao.Unbind();
@@ -53,4 +55,88 @@ void Renderer::RenderNoTexture(gl::VertexArray & vao, gl::ElementArrayBuffer & e
     material.shader->Unbind();
 }
 
+void Renderer::BindQuadIndices(gl::VertexArray& vao)
+{
+    // The element buffer binding is part of the VAO state
+    vao.Bind();
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, getQuadIndices().EBO);
+    vao.Unbind();
+}
+
+void Renderer::RenderQuads(Entity & entity, gl::Material & material, const std::vector<QuadRange>& ranges)
+{
+    // Every range is drawn from its own base vertex, the indicies only reach 65536 verticies
+    // so ranges past MAX_QUADS are split. The arrays are kept around since this runs for every chunk
+    static std::vector<GLsizei> counts;
+    static std::vector<const void*> offsets;
+    static std::vector<GLint> baseVerticies;
+    counts.clear();
+    offsets.clear();
+    baseVerticies.clear();
+    for (const QuadRange& range : ranges)
+    {
+        for (size_t first = 0; first < range.count; first += MAX_QUADS)
+        {
+            counts.push_back((GLsizei)(std::min(range.count - first, MAX_QUADS) * 6));
+            offsets.push_back(nullptr);
+            baseVerticies.push_back((GLint)((range.first + first) * 4));
+        }
+    }
+    if (counts.empty())
+        return;
+
+    material.shader->Bind();
+
+    // Check if a texture exists and try to load it
+    if (entity.texture.texture != (GLuint)-1)
+        entity.texture.activateAndBind();
+    else printf("[Renderer]: Could not bind texture!\n");
+
+    entity.VAO.Bind();
+    gl::glClearErrors();
+    glMultiDrawElementsBaseVertex(GL_TRIANGLES, counts.data(), GL_UNSIGNED_SHORT, offsets.data(), (GLsizei)counts.size(), baseVerticies.data());
+    drawCalls++;
+    gl::glCheckError(__FILE__, __LINE__);
+    entity.VAO.Unbind();
+
+    material.shader->Unbind();
+}
+
+/**
+ * Desc. Returns the quad index buffer shared by every entity drawn with RenderQuads()
+ *
+ * Note. It's created on first use since it needs a GL context and lives until
+ * ReleaseQuadIndices(), the App releases it right before destroying the context
+*/
+gl::ElementArrayBuffer& Renderer::getQuadIndices()
+{
+    if (quadIndices == nullptr)
+    {
+        std::vector<GLushort> data;
+        data.reserve(MAX_QUADS * 6);
+        for (size_t quad = 0; quad < MAX_QUADS; quad++)
+        {
+            const GLushort first = (GLushort)(quad * 4);
+            for (GLushort index : { 0, 1, 3, 3, 1, 2 })
+                data.push_back(first + index);
+        }
+
+        quadIndices = std::make_unique<gl::ElementArrayBuffer>();
+        quadIndices->setData(data);
+    }
+    return *quadIndices;
+}
+
+/**
+ * Desc. Deletes the shared quad index buffer
+ *
+ * Note. Every VAO that is bound to it should be gone already, the next
+ * BindQuadIndices() would create it again
+*/
+void Renderer::ReleaseQuadIndices()
+{
+    quadIndices.reset();
+}
+
+std::unique_ptr<gl::ElementArrayBuffer> Renderer::quadIndices;
 int Renderer::drawCalls = 0;
\ No newline at end of file
@@ -1,4 +1,5 @@
 #pragma once
+#include <memory>
 #include "../gl/glObjects.h"
 
 struct Entity;
@@ -14,7 +15,28 @@ public:
     static void RenderEntity(Entity& entity, gl::Material& material, GLenum mode = GL_TRIANGLES);
     static void RenderNoTexture(gl::VertexArray& vao, gl::ElementArrayBuffer& ebo, gl::Material& material, GLenum mode = GL_TRIANGLES);
 
+    // Quads in the shared quad index buffer, it has 16-bit indicies so this is as many quads as 65536 verticies
+    static const size_t MAX_QUADS = 16384;
+
+    // A run of quads in an entities VBO, first is counted in quads from the start of the buffer
+    struct QuadRange
+    {
+        size_t first;
+        size_t count;
+    };
+
+    // Binds the shared quad index buffer to vao, entities drawn with RenderQuads() need this once
+    static void BindQuadIndices(gl::VertexArray& vao);
+    // Deletes the shared quad index buffer, has to be called before the GL context is destroyed
+    static void ReleaseQuadIndices();
+    // Draws runs of quads (4 verticies each, the same winding as Cube::indicies) from the same VBO
+    // with one multi draw call, using the shared quad index buffer instead of the entities own EBO
+    static void RenderQuads(Entity& entity, gl::Material& material, const std::vector<QuadRange>& ranges);
+
     static int drawCalls;
 
 private:
+    static std::unique_ptr<gl::ElementArrayBuffer> quadIndices;
+
+    static gl::ElementArrayBuffer& getQuadIndices();
 };
\ No newline at end of file
@@ -7,9 +7,15 @@
 #define toStr(x) std::to_string(x)
 #define HOTBAR_SIZE 7
 #define CHUNK_SIZE 32
+#define RENDER_DISTANCE 6
+#define RENDER_HEIGHT 3
+#define CHUNK_MEMORY_BUDGET (128 * 1024 * 1024)
+#define BRUSH_RADIUS 3
 
 Playing::Playing()
-    : uirenderer({ App::ScreenWidth(), App::ScreenHeight() })
+    : atlas("resources/textures/textureAtlas.png", 2048, 256)
+    , chunk_manager(&atlas)
+    , uirenderer({ App::ScreenWidth(), App::ScreenHeight() })
 {
 }
 
@@ -20,24 +26,30 @@ void Playing::Event(SDL_Event & e)
     {
         if (lastRayPos.x != INFINITY)
         {
+            WorldView world(chunk_manager);
+
             glm::vec3 temp_ray = lastRayPos;
             // Keep looping until we either find an AIR block or get out of bounds and get -1
-            while (chunk_manager.getBlockGlobal(temp_ray.x, temp_ray.y, temp_ray.z) != 0 &&
-                chunk_manager.getBlockGlobal(temp_ray.x, temp_ray.y, temp_ray.z) != -1
+            while (world.getBlock(temp_ray) != 0 &&
+                world.getBlock(temp_ray) != -1
                 )
             {
                 temp_ray += lastUnitRay * 0.05f;
             }
 
             // We still have to check if we got -1(OutOfBounds) or 0(AIR)
-            if (chunk_manager.getBlockGlobal(temp_ray.x, temp_ray.y, temp_ray.z) == 0)
+            if (world.getBlock(temp_ray) == 0)
             {
-                // Set the block and update the chunk and it's neighbours
-                chunk_manager.setBlockGlobal(temp_ray.x, temp_ray.y, temp_ray.z, hotbar[hotbar_selection]);
-
-                auto chunk = chunk_manager.getChunkFromGlobal(lastRayPos.x, lastRayPos.y, lastRayPos.z);
-                chunk->Update(); // regenerate chunk mesh
-                chunk->UpdateNeighbours();
+                // Shift places a ball of the block in creative mode, it's remeshed and undone as one edit
+                if (bCreativeMode && App::GetKeys()[SDL_SCANCODE_LSHIFT])
+                {
+                    EditBatch batch(chunk_manager);
+                    batch.fillSphere(glm::ivec3(glm::floor(temp_ray)), BRUSH_RADIUS, hotbar[hotbar_selection]);
+                }
+                // Set the block, the chunk and the neighbours it borders get remeshed
+                // by the next chunk_manager.Update()
+                else
+                    chunk_manager.setBlockGlobal(temp_ray, hotbar[hotbar_selection]);
             }
         }
     }
@@ -62,6 +74,21 @@ void Playing::Event(SDL_Event & e)
         App::WireFrame(bWireframe);
     }
 
+    // Undo & Redo block changes
+    if (e.type == SDL_KEYDOWN && (e.key.keysym.mod & KMOD_CTRL))
+    {
+        if (e.key.keysym.scancode == SDL_SCANCODE_Z)        chunk_manager.undo();
+        else if (e.key.keysym.scancode == SDL_SCANCODE_Y)   chunk_manager.redo();
+    }
+
+    // Switch between greedy and naive meshing, for comparing them
+    if (e.type == SDL_KEYDOWN && e.key.keysym.scancode == SDL_SCANCODE_G)
+    {
+        bool greedy = ChunkMesher::getMode() == ChunkMesher::Mode::GREEDY;
+        chunk_manager.setMeshMode(greedy ? ChunkMesher::Mode::NAIVE : ChunkMesher::Mode::GREEDY);
+        printf("%s meshing\n", greedy ? "Naive" : "Greedy");
+    }
+
     // Enter & Exit Creative Mode
     if (e.type == SDL_KEYDOWN && e.key.keysym.scancode == SDL_SCANCODE_C)
     {
@@ -82,20 +109,28 @@ void Playing::Setup()
     App::ClearColor(64, 191, 255, 255);
 
     shader.createProgram("resources/shaders/shader");
+    chunk_shader.createProgram("resources/shaders/chunk");
     outline.createProgram("resources/shaders/outline_shader");
 
     shader_material.setShader(&shader);
+    chunk_material.setShader(&chunk_shader);
     outline_material.setShader(&outline);
 
+    // Chunk vertices only carry the index of their atlas tile
+    chunk_material.setUniform("atlasTiles", atlas.TEX_PER_ROW);
+
     breakingCube.texture.loadTexture("resources/textures/textureAtlas.png");
 
-    // Create chunks
-    chunk_manager.generateChunks(4, 4, 4);
-    chunk_manager.generateTerrain(CHUNK_SIZE, CHUNK_SIZE * 3);
-    printf("Created %d chunk(s)\n", chunk_manager.chunks.size());
+    // Chunks are streamed in around the camera by chunk_manager.Update()
+    chunk_manager.setTerrain(CHUNK_SIZE, CHUNK_SIZE * 3, Math::iRandom(0, 65536));
+    chunk_manager.openWorld("saves/world");
+    chunk_manager.setStreamingRadius(RENDER_DISTANCE, RENDER_HEIGHT);
+    chunk_manager.setRenderDistance(RENDER_DISTANCE, RENDER_HEIGHT);
+    chunk_manager.setMemoryBudget(CHUNK_MEMORY_BUDGET);
 
-    // Initial player position is in the middle of the map
-    camera.setPosition({ (chunk_manager.worldSize.x / 2) * CHUNK_SIZE, (chunk_manager.worldSize.y / 2) * CHUNK_SIZE, (chunk_manager.worldSize.z / 2) * CHUNK_SIZE });
+    // Initial player position is just above the terrain
+    const int spawn = 2 * CHUNK_SIZE;
+    camera.setPosition({ spawn, chunk_manager.getTerrainHeight(spawn, spawn) + 3, spawn });
     velocity = { 0, 0, 0 };
 
     // Initial hotbar items
@@ -136,11 +171,15 @@ void Playing::Loop(float elapsed)
     if (bCreativeMode) camera.Movement(App::GetKeys(), elapsed);
     else if (!bCreativeMode) CollisionMovement(10, elapsed);
 
-    // Ray casting
+    // Load chunks around the player and unload the ones left behind
+    chunk_manager.Update(camera.getPosition());
+
+    // Ray casting, the ray takes ~120 steps through at most a few chunks
+    WorldView world(chunk_manager);
     for (Math::Ray ray(camera.getPosition(), camera.getRotation()); ray.getLength() < 6; ray.step(0.05f))
     {
         glm::vec3 r = ray.getEnd();
-        if (chunk_manager.getBlockGlobal(r.x, r.y, r.z) > 0)
+        if (world.isSolid(r))
         {
             // Save the first blocks position that was hit and break out of the loop
             lastRayPos = r;
@@ -156,13 +195,35 @@ void Playing::Loop(float elapsed)
         else lastRayPos = glm::vec3(INFINITY, 0, 0);
     }
 
+    // Only chunks inside of the view get drawn, everything else can be evicted
+    Math::Frustum frustum(
+        Math::createProjectionMatrix(glm::vec2(App::ScreenWidth(), App::ScreenHeight())) *
+        Math::createViewMatrix(camera)
+    );
+
     // Render chunks in the chunk_manager
-    for (auto& i : chunk_manager.chunks)
+    for (auto i : chunk_manager.chunks)
     {
-        shader_material.setUniform("MVPMatrix", Math::createMVPMatrix(
-            i->chunk, camera, glm::vec2(App::ScreenWidth(), App::ScreenHeight())
+        // Chunks outside of the render distance have no mesh at all
+        ChunkMesh* mesh = i->getMesh();
+        if (mesh == nullptr)
+            continue;
+
+        glm::vec3 min = i->getPosition();
+        if (!frustum.isBoxVisible(min, min + glm::vec3(chunk_manager.chunkSize)))
+            continue;
+
+        // Evicted chunks are queued to be generated again
+        chunk_manager.touch(i);
+
+        // Chunks that are empty, buried or evicted have no mesh to draw
+        if (!i->hasMesh())
+            continue;
+
+        chunk_material.setUniform("MVPMatrix", Math::createMVPMatrix(
+            mesh->entity, camera, glm::vec2(App::ScreenWidth(), App::ScreenHeight())
         ));
-        Renderer::RenderEntity(i->chunk, shader_material);
+        Renderer::RenderQuads(mesh->entity, chunk_material, mesh->getRanges());
     }
 
     // Render selected block outline
@@ -206,9 +267,9 @@ void Playing::Resume()
 void Playing::createCubeOutline(float x, float y, float z, int width)
 {
     // Set to intiger space because the cubes are 1*1*1 in size
-    x = int(x);
-    y = int(y);
-    z = int(z);
+    x = floorf(x);
+    y = floorf(y);
+    z = floorf(z);
 
     std::vector<float> vert = {
         x + 0, y + 1, z + 1,
@@ -252,15 +313,15 @@ void Playing::createCubeOutline(float x, float y, float z, int width)
 void Playing::createBreakingAnimation(glm::ivec2 breakAnimTexCoords)
 {
     // Cube is 1*1*1 - int space
-    int x = (int)lastRayPos.x;
-    int y = (int)lastRayPos.y;
-    int z = (int)lastRayPos.z;
+    int x = (int)floorf(lastRayPos.x);
+    int y = (int)floorf(lastRayPos.y);
+    int z = (int)floorf(lastRayPos.z);
 
     // Setup for 6 faces
     std::vector<float> texCoords;
     for (int i = 0; i < 6; i++)
     {
-        auto temp = chunk_manager.atlas.getTextureCoords(breakAnimTexCoords);
+        auto temp = atlas.getTextureCoords(breakAnimTexCoords);
         texCoords.insert(texCoords.end(), temp.begin(), temp.end());
     }
 
@@ -329,10 +390,10 @@ void Playing::breakBlockAction(float elapsed)
     if (App::MouseHold(SDL_BUTTON_LEFT))
     {
         // Player changed of the block that was being broken so reset timer
-        if (breakingBlockPos != glm::ivec3(lastRayPos))
+        if (breakingBlockPos != glm::ivec3(glm::floor(lastRayPos)))
             totalTime = 0.0f;
 
-        breakingBlockPos = glm::ivec3(lastRayPos);
+        breakingBlockPos = glm::ivec3(glm::floor(lastRayPos));
 
         // Get breaking time based on the block that we are breaking
         int block = chunk_manager.getBlockGlobal(breakingBlockPos.x, breakingBlockPos.y, breakingBlockPos.z);
@@ -344,12 +405,16 @@ void Playing::breakBlockAction(float elapsed)
             // If the ray doesn't hit a block the X part gets set to INFINITY
             if (lastRayPos.x != INFINITY)
             {
-                // Set the block to air if it's destroyed
-                chunk_manager.setBlockGlobal(lastRayPos.x, lastRayPos.y, lastRayPos.z, 0);
-                // Update the chunk mesh and the surrounding neighbours as well
-                auto chunk = chunk_manager.getChunkFromGlobal(lastRayPos.x, lastRayPos.y, lastRayPos.z);
-                chunk->Update();
-                chunk->UpdateNeighbours();
+                // Shift clears a ball around the block in creative mode
+                if (bCreativeMode && App::GetKeys()[SDL_SCANCODE_LSHIFT])
+                {
+                    EditBatch batch(chunk_manager);
+                    batch.fillSphere(glm::ivec3(glm::floor(lastRayPos)), BRUSH_RADIUS, Blocks::AIR);
+                }
+                // Set the block to air if it's destroyed, the chunk mesh and the neighbours
+                // whose border it is on get updated by the next chunk_manager.Update()
+                else
+                    chunk_manager.setBlockGlobal(lastRayPos, 0);
 
                 // Reset totalTime
                 totalTime = 0.0f;
@@ -375,6 +440,9 @@ void Playing::CollisionMovement(float speed, float elapsed)
     glm::vec3 position = camera.getPosition();
     glm::vec3 rotation = camera.getRotation();
 
+    // Every check below is around the player so they mostly hit the same chunk
+    WorldView world(chunk_manager);
+
     if (App::GetKeys()[SDL_SCANCODE_W])
     {
         // Calculate the directional vector and add it to camera position
@@ -400,7 +468,7 @@ void Playing::CollisionMovement(float speed, float elapsed)
     if (App::GetKeys()[SDL_SCANCODE_SPACE])
     {
         // Only jump if the player donesn't have air blocks under him
-        if (chunk_manager.getBlockGlobal(position.x, position.y - Height - 1, position.z) > 0)
+        if (world.isSolid({ position.x, position.y - Height - 1, position.z }))
             velocity.y = 10.0f * elapsed * Height;
     }
 
@@ -424,34 +492,34 @@ void Playing::CollisionMovement(float speed, float elapsed)
     else
         movedPos.z += Offset;
 
-    if (chunk_manager.getBlockGlobal(movedPos.x, movedPos.y, movedPos.z) >= 0)
+    if (world.getBlock(movedPos) >= 0)
     {
         // NOTE: The player is 2 blocks in height so we have to check 2 blocks for x, y, z
 
         // X-Axis
         // Check upper (camera) block
-        if (chunk_manager.getBlockGlobal(movedPos.x, position.y, position.z) != 0)
+        if (world.getBlock({ movedPos.x, position.y, position.z }) != 0)
             velocity.x = 0;
         // Check lower block
-        if (chunk_manager.getBlockGlobal(movedPos.x, position.y - Height, position.z) != 0)
+        if (world.getBlock({ movedPos.x, position.y - Height, position.z }) != 0)
             velocity.x = 0;
 
         // Y-Axis
         // Same thing, check the block under the player and above the player
-        if (chunk_manager.getBlockGlobal(position.x, movedPos.y - Height, position.z) != 0)
+        if (world.getBlock({ position.x, movedPos.y - Height, position.z }) != 0)
             velocity.y = 0;
-        if (chunk_manager.getBlockGlobal(position.x, movedPos.y, position.z) != 0)
+        if (world.getBlock({ position.x, movedPos.y, position.z }) != 0)
             velocity.y = 0;
 
         // Z-Axis
-        if (chunk_manager.getBlockGlobal(position.x, position.y, movedPos.z) != 0)
+        if (world.getBlock({ position.x, position.y, movedPos.z }) != 0)
             velocity.z = 0;
-        if (chunk_manager.getBlockGlobal(position.x, position.y - Height, movedPos.z) != 0)
+        if (world.getBlock({ position.x, position.y - Height, movedPos.z }) != 0)
             velocity.z = 0;
 
     }
     // Keep the player inside of chunk borders by making sure he can only travel through air blocks
-    else if (chunk_manager.getBlockGlobal(movedPos.x, movedPos.y, movedPos.z) == -1)
+    else if (world.getBlock(movedPos) == -1)
     {
         velocity = { 0, 0, 0 };
     }
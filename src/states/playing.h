@@ -3,6 +3,8 @@
 
 #include "../world/blocks.h"
 #include "../world/chunkmanager.h"
+#include "../world/editbatch.h"
+#include "../world/worldview.h"
 #include "../util/math.h"
 #include "../util/cube.h"
 #include "../util/camera.h"
@@ -24,7 +26,9 @@ public:
 
 private:
     gl::Shader shader;
+    gl::Shader chunk_shader;
     Camera camera;
+    gl::TextureAtlas atlas;
     ChunkManager chunk_manager;
     glm::vec3 lastRayPos;
     glm::vec3 lastUnitRay;
@@ -33,6 +37,7 @@ private:
     gl::Shader outline;
 
     gl::Material shader_material;
+    gl::Material chunk_material;
     gl::Material outline_material;
 
     glm::vec3 velocity;
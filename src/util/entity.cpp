@@ -1,9 +1,15 @@
-#include "Entity.h"
+#include "entity.h"
 
 Entity::Entity()
+    : Entity(true)
+{
+}
+
+Entity::Entity(bool createEBO)
     : position(0, 0, 0)
     , rotation(0, 0, 0)
     , scale(1, 1, 1)
+    , EBO(createEBO)
 {
 }
 
@@ -18,7 +24,7 @@ void Entity::setVBO(const std::vector<GLfloat>& data, int attributeID, int size,
 {
     VAO.Bind();
     auto VBO = std::make_unique<gl::VertexBufferObject>();
-    VBO->setData(data, attributeID, size, stride, offset, DrawMode);
+    VBO->setData(data, data.size() * sizeof(GLfloat), attributeID, size, stride, offset, DrawMode);
     VBOs.push_back(std::move(VBO));
     VAO.Unbind();
 }
@@ -26,7 +32,23 @@ void Entity::setVBO(const std::vector<GLfloat>& data, int attributeID, int size,
 void Entity::updateVBO(int index, const std::vector<GLfloat>& data, int attributeID, int size, GLsizei stride, const void * offset, int DrawMode)
 {
     VAO.Bind();
-    VBOs[index]->setData(data, attributeID, size, stride, offset, DrawMode);
+    VBOs[index]->setData(data, data.size() * sizeof(GLfloat), attributeID, size, stride, offset, DrawMode);
+    VAO.Unbind();
+}
+
+void Entity::setVBO(const std::vector<GLuint>& data, int attributeID, int size, int DrawMode)
+{
+    VAO.Bind();
+    auto VBO = std::make_unique<gl::VertexBufferObject>();
+    VBO->setData(data, attributeID, size, DrawMode);
+    VBOs.push_back(std::move(VBO));
+    VAO.Unbind();
+}
+
+void Entity::updateVBO(int index, const std::vector<GLuint>& data, int attributeID, int size, int DrawMode)
+{
+    VAO.Bind();
+    VBOs[index]->setData(data, attributeID, size, DrawMode);
     VAO.Unbind();
 }
 
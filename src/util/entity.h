@@ -7,6 +7,9 @@ class Camera;
 struct Entity
 {
     Entity();
+    // Entities drawn with a shared index buffer (Renderer::RenderQuads()) don't need their own EBO,
+    // without createEBO it's only created by setEBO()
+    explicit Entity(bool createEBO);
 
     glm::vec3 position, rotation, scale;
 
@@ -16,6 +19,8 @@ struct Entity
     void setEBO(const std::vector<GLuint>& indicies, int DrawMode = GL_STATIC_DRAW);
     void setVBO(const std::vector<GLfloat>& data, int attributeID, int size, GLsizei stride = 0, const void * offset = nullptr, int DrawMode = GL_STATIC_DRAW);
     void updateVBO(int index, const std::vector<GLfloat>& data, int attributeID, int size, GLsizei stride = 0, const void * offset = nullptr, int DrawMode = GL_STATIC_DRAW);
+    void setVBO(const std::vector<GLuint>& data, int attributeID, int size, int DrawMode = GL_STATIC_DRAW);
+    void updateVBO(int index, const std::vector<GLuint>& data, int attributeID, int size, int DrawMode = GL_STATIC_DRAW);
 
     void freeVBOs();
 
@@ -59,6 +59,22 @@ float Math::map(float s, float a1, float a2, float b1, float b2)
     return b1 + ((s - a1) * (b2 - b1)) / (a2 - a1);
 }
 
+int Math::floorDiv(int a, int b)
+{
+    int q = a / b;
+    if ((a % b != 0) && ((a < 0) != (b < 0)))
+        q--;
+    return q;
+}
+
+int Math::floorMod(int a, int b)
+{
+    int m = a % b;
+    if (m != 0 && ((m < 0) != (b < 0)))
+        m += b;
+    return m;
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 // Raycasting reference
@@ -100,6 +116,43 @@ float Math::Ray::getLength() const
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+// Frustum plane extraction (Gribb & Hartmann)
+// https://www.gamedevs.org/uploads/fast-extraction-viewing-frustum-planes-from-world-view-projection-matrix.pdf
+
+Math::Frustum::Frustum(const glm::mat4x4& viewProjection)
+{
+    // glm matrices are column major so m[column][row]
+    const glm::mat4x4& m = viewProjection;
+    for (int i = 0; i < 3; i++)
+    {
+        glm::vec4 row(m[0][i], m[1][i], m[2][i], m[3][i]);
+        glm::vec4 w(m[0][3], m[1][3], m[2][3], m[3][3]);
+
+        m_planes[i * 2 + 0] = w + row;
+        m_planes[i * 2 + 1] = w - row;
+    }
+}
+
+bool Math::Frustum::isBoxVisible(const glm::vec3& min, const glm::vec3& max) const
+{
+    for (const auto& plane : m_planes)
+    {
+        // Test the corner of the box that is furthest along the planes normal
+        glm::vec3 corner(
+            plane.x > 0 ? max.x : min.x,
+            plane.y > 0 ? max.y : min.y,
+            plane.z > 0 ? max.z : min.z
+        );
+
+        if (glm::dot(glm::vec3(plane), corner) + plane.w < 0)
+            return false;
+    }
+
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
 // Check for explenation on different values
 // https://www.redblobgames.com/maps/terrain-from-noise/#elevation
 // The values in the tutorial above for rougness is 0.5 and smoothness is 2
@@ -31,6 +31,11 @@ namespace Math
     // Maps values from one range to another
     float map(float s, float a1, float a2, float b1, float b2);
 
+    // Integer division and modulo that round towards negative infinity
+    // - floorDiv(-1, 32) = -1 and floorMod(-1, 32) = 31
+    int floorDiv(int a, int b);
+    int floorMod(int a, int b);
+
     // Ray class
     class Ray
     {
@@ -48,6 +53,19 @@ namespace Math
         glm::vec3 m_rayEnd;
         glm::vec3 m_direction;
     };
+
+    // View frustum planes taken from a view projection matrix
+    class Frustum
+    {
+    public:
+        Frustum(const glm::mat4x4& viewProjection);
+
+        // Returns true if the axis aligned box is (at least partly) inside of the frustum
+        bool isBoxVisible(const glm::vec3& min, const glm::vec3& max) const;
+
+    private:
+        glm::vec4 m_planes[6];
+    };
 };
 
 namespace Noise
@@ -4,6 +4,14 @@
  * Desc. Returns the texture coordinates of a given blocks face
 */
 std::vector<GLfloat> Blocks::getTextureCoords(BLOCK id, Cube::CubeFace face, gl::TextureAtlas& atlas)
+{
+    return atlas.getTextureCoords(getTextureTile(id, face));
+}
+
+/**
+ * Desc. Returns the atlas tile of a given blocks face
+*/
+glm::ivec2 Blocks::getTextureTile(BLOCK id, Cube::CubeFace face)
 {
     glm::ivec2 coords;
     switch (id)
@@ -53,7 +61,7 @@ std::vector<GLfloat> Blocks::getTextureCoords(BLOCK id, Cube::CubeFace face, gl:
         coords = { 7, 7 };
     }
 
-    return atlas.getTextureCoords(coords);
+    return coords;
 }
 
 float Blocks::getBreakTime(BLOCK block)
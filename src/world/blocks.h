@@ -23,6 +23,8 @@ public:
     };
 
     static std::vector<GLfloat> getTextureCoords(BLOCK id, Cube::CubeFace face, gl::TextureAtlas& atlas);
+    // Position of the texture in the atlas grid
+    static glm::ivec2 getTextureTile(BLOCK id, Cube::CubeFace face);
 
     static float getBreakTime(BLOCK block);
 };
\ No newline at end of file
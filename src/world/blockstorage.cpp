@@ -0,0 +1,339 @@
+#include "blockstorage.h"
+
+#include <algorithm>
+#include <cstring>
+
+BlockStorage::BlockStorage(int size, uint16_t initialBlock)
+    : m_size(size)
+    , m_bits(0)
+    , m_bitsLog2(0)
+    , m_mask(0)
+{
+    // Every block starts as the initial block so the storage is uniform
+    // and doesn't need an index array yet
+    m_palette.push_back(initialBlock);
+    m_counts.push_back((uint32_t)size);
+}
+
+void BlockStorage::reset(uint16_t initialBlock)
+{
+    m_palette.assign(1, initialBlock);
+    m_counts.assign(1, (uint32_t)m_size);
+    m_data.clear();
+    m_bits = 0;
+    m_bitsLog2 = 0;
+    m_mask = 0;
+}
+
+uint16_t BlockStorage::get(int index) const
+{
+    if (m_bits == 0)
+        return m_palette[0];
+
+    return m_palette[getIndex(index)];
+}
+
+void BlockStorage::set(int index, uint16_t blockid)
+{
+    if (m_bits == 0 && m_palette[0] == blockid)
+        return;
+
+    // The palette only grows here so the old index stays valid
+    const int before = (m_bits == 0) ? 0 : (int)getIndex(index);
+    const int after = paletteIndex(blockid);
+    if (before == after)
+        return;
+
+    setIndex(index, after);
+    m_counts[before]--;
+    m_counts[after]++;
+}
+
+void BlockStorage::unpack(uint16_t * out) const
+{
+    if (m_bits == 0)
+    {
+        std::fill(out, out + m_size, m_palette[0]);
+        return;
+    }
+
+    // Walk word by word so every word is only loaded once
+    const int perWord = 64 >> m_bitsLog2;
+    int i = 0;
+    for (uint64_t word : m_data)
+    {
+        for (int j = 0; j < perWord && i < m_size; j++, i++)
+        {
+            out[i] = m_palette[word & m_mask];
+            word >>= m_bits;
+        }
+    }
+}
+
+void BlockStorage::unpack(uint16_t* out, int first, int count) const
+{
+    if (m_bits == 0)
+    {
+        std::fill(out, out + count, m_palette[0]);
+        return;
+    }
+
+    const int perWord = 64 >> m_bitsLog2;
+    int w = first / perWord;
+    int j = first % perWord;
+    uint64_t word = m_data[w] >> (j * m_bits);
+    for (int i = 0; i < count; i++, j++)
+    {
+        if (j == perWord)
+        {
+            word = m_data[++w];
+            j = 0;
+        }
+        out[i] = m_palette[word & m_mask];
+        word >>= m_bits;
+    }
+}
+
+void BlockStorage::compact()
+{
+    if (m_bits == 0)
+        return;
+
+    // Nothing to drop if every entry is used and the indices are as small as they get
+    if (std::find(m_counts.begin(), m_counts.end(), 0u) == m_counts.end() && bitsFor(m_palette.size()) == m_bits)
+        return;
+
+    std::vector<uint16_t> indices(m_size);
+    for (int i = 0; i < m_size; i++)
+        indices[i] = (uint16_t)getIndex(i);
+
+    // Find which palette entries are still in use
+    std::vector<int> remap(m_palette.size(), -1);
+    std::vector<uint16_t> palette;
+    std::vector<uint32_t> counts;
+    for (uint16_t index : indices)
+    {
+        if (remap[index] == -1)
+        {
+            remap[index] = (int)palette.size();
+            palette.push_back(m_palette[index]);
+            counts.push_back(m_counts[index]);
+        }
+    }
+
+    const int bits = bitsFor(palette.size());
+    if (palette.size() == m_palette.size() && bits == m_bits)
+        return;
+
+    m_palette.swap(palette);
+    m_counts.swap(counts);
+    m_data.clear();
+    m_bits = 0;
+    resize(bits);
+
+    if (m_bits == 0)
+        return;
+
+    for (int i = 0; i < m_size; i++)
+        setIndex(i, remap[indices[i]]);
+}
+
+/*
+    Serialized layout
+    -----------------
+    uint8_t  bits per block
+    uint16_t palette size
+    uint16_t palette[palette size]
+    uint64_t data[]             (only if bits per block > 0)
+*/
+void BlockStorage::serialize(std::vector<uint8_t>& out) const
+{
+    uint8_t  bits = (uint8_t)m_bits;
+    uint16_t paletteSize = (uint16_t)m_palette.size();
+
+    size_t start = out.size();
+    out.resize(start + sizeof(bits) + sizeof(paletteSize) + m_palette.size() * sizeof(uint16_t) + m_data.size() * sizeof(uint64_t));
+
+    uint8_t* p = out.data() + start;
+    memcpy(p, &bits, sizeof(bits));                                  p += sizeof(bits);
+    memcpy(p, &paletteSize, sizeof(paletteSize));                    p += sizeof(paletteSize);
+    memcpy(p, m_palette.data(), m_palette.size() * sizeof(uint16_t)); p += m_palette.size() * sizeof(uint16_t);
+    memcpy(p, m_data.data(), m_data.size() * sizeof(uint64_t));
+}
+
+bool BlockStorage::deserialize(const uint8_t* data, size_t size)
+{
+    uint8_t  bits;
+    uint16_t paletteSize;
+    if (size < sizeof(bits) + sizeof(paletteSize))
+        return false;
+
+    memcpy(&bits, data, sizeof(bits));                   data += sizeof(bits);
+    memcpy(&paletteSize, data, sizeof(paletteSize));     data += sizeof(paletteSize);
+    size -= sizeof(bits) + sizeof(paletteSize);
+
+    if (bits != 0 && bits != 1 && bits != 2 && bits != 4 && bits != 8 && bits != 16)
+        return false;
+    if (paletteSize == 0 || paletteSize > (size_t(1) << bits) || size < paletteSize * sizeof(uint16_t))
+        return false;
+
+    size_t words = 0;
+    if (bits > 0)
+    {
+        const size_t perWord = 64 / bits;
+        words = (m_size + perWord - 1) / perWord;
+    }
+    if (size != paletteSize * sizeof(uint16_t) + words * sizeof(uint64_t))
+        return false;
+
+    m_palette.resize(paletteSize);
+    memcpy(m_palette.data(), data, paletteSize * sizeof(uint16_t));
+    data += paletteSize * sizeof(uint16_t);
+
+    m_data.clear();
+    m_bits = 0;
+    resize(bits);
+
+    if (words > 0)
+        memcpy(m_data.data(), data, words * sizeof(uint64_t));
+
+    // Count the blocks of every entry, an index past the palette means the data is broken
+    m_counts.assign(paletteSize, 0);
+    if (m_bits == 0)
+        m_counts[0] = (uint32_t)m_size;
+    for (int i = 0; i < m_size && m_bits > 0; i++)
+    {
+        uint64_t index = getIndex(i);
+        if (index >= paletteSize)
+        {
+            reset(m_palette[0]);
+            return false;
+        }
+        m_counts[index]++;
+    }
+    return true;
+}
+
+bool BlockStorage::isUniform() const
+{
+    return m_bits == 0;
+}
+
+uint16_t BlockStorage::getUniformBlock() const
+{
+    return m_palette[0];
+}
+
+int BlockStorage::count(uint16_t blockid) const
+{
+    for (int i = 0; i < (int)m_palette.size(); i++)
+        if (m_palette[i] == blockid)
+            return (int)m_counts[i];
+
+    return 0;
+}
+
+bool BlockStorage::contains(uint16_t blockid) const
+{
+    return count(blockid) > 0;
+}
+
+int BlockStorage::size() const
+{
+    return m_size;
+}
+
+int BlockStorage::getBitsPerBlock() const
+{
+    return m_bits;
+}
+
+int BlockStorage::getPaletteSize() const
+{
+    return (int)m_palette.size();
+}
+
+size_t BlockStorage::getMemoryUsage() const
+{
+    return sizeof(BlockStorage) + m_palette.capacity() * sizeof(uint16_t) + m_counts.capacity() * sizeof(uint32_t) + m_data.capacity() * sizeof(uint64_t);
+}
+
+/**
+ * Desc. Returns the palette index of blockid, adds it to the palette
+ * and widens the stored indices if it doesn't fit
+*/
+int BlockStorage::paletteIndex(uint16_t blockid)
+{
+    for (int i = 0; i < (int)m_palette.size(); i++)
+        if (m_palette[i] == blockid)
+            return i;
+
+    m_palette.push_back(blockid);
+    m_counts.push_back(0);
+    if (m_palette.size() > (size_t(1) << m_bits))
+        resize(m_bits == 0 ? 1 : m_bits * 2);
+
+    return (int)m_palette.size() - 1;
+}
+
+/**
+ * Desc. Repacks every index into the new bit width
+ *
+ * Note. Going from 0 bits every index is 0 which is what assign() fills with,
+ * the index array is then filled in place so a reset() storage reuses its memory
+*/
+void BlockStorage::resize(int bits)
+{
+    std::vector<uint64_t> old;
+    if (!m_data.empty())
+        old.swap(m_data);
+    const int      oldBits     = m_bits;
+    const int      oldBitsLog2 = m_bitsLog2;
+    const uint64_t oldMask     = m_mask;
+
+    m_bits = bits;
+    m_bitsLog2 = 0;
+    while ((1 << m_bitsLog2) < m_bits)
+        m_bitsLog2++;
+    m_mask = (uint64_t(1) << m_bits) - 1;
+
+    if (m_bits == 0)
+        return;
+
+    const int perWord = 64 >> m_bitsLog2;
+    m_data.assign((m_size + perWord - 1) / perWord, 0);
+
+    if (old.empty())
+        return;
+
+    const int oldPerWord = 64 >> oldBitsLog2;
+    for (int i = 0; i < m_size; i++)
+    {
+        uint64_t value = (old[i / oldPerWord] >> ((i % oldPerWord) * oldBits)) & oldMask;
+        setIndex(i, value);
+    }
+}
+
+// Smallest index width that fits paletteSize entries
+int BlockStorage::bitsFor(size_t paletteSize)
+{
+    int bits = 0;
+    while ((size_t(1) << bits) < paletteSize)
+        bits = (bits == 0) ? 1 : bits * 2;
+
+    return bits;
+}
+
+uint64_t BlockStorage::getIndex(int index) const
+{
+    const int word  = index >> (6 - m_bitsLog2);
+    const int shift = (index & ((64 >> m_bitsLog2) - 1)) << m_bitsLog2;
+    return (m_data[word] >> shift) & m_mask;
+}
+
+void BlockStorage::setIndex(int index, uint64_t value)
+{
+    const int word  = index >> (6 - m_bitsLog2);
+    const int shift = (index & ((64 >> m_bitsLog2) - 1)) << m_bitsLog2;
+    m_data[word] = (m_data[word] & ~(m_mask << shift)) | (value << shift);
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*
+    Palette compressed block storage
+    --------------------------------
+    Instead of storing a full block id for every voxel we keep a small palette of the
+    block ids that actually appear in the chunk and store a bit-packed palette index
+    per voxel. The index width grows 1 -> 2 -> 4 -> 8 -> 16 bits as the palette fills up,
+    so a chunk with only AIR, DIRT and STONE uses 2 bits per block instead of 8.
+
+    Index widths are powers of two so an index never straddles two 64-bit words.
+    A palette with a single entry uses 0 bits, the chunk is then uniform and has no
+    index array at all until a different block is set.
+
+    Every palette entry also counts how many blocks use it, so questions like "is
+    there any WATER" are a walk over the palette instead of over every block.
+*/
+class BlockStorage
+{
+public:
+    BlockStorage(int size, uint16_t initialBlock = 0);
+
+    // Sets every block to initialBlock, keeps the allocated index array for reuse
+    void reset(uint16_t initialBlock = 0);
+
+    uint16_t get(int index) const;
+    void     set(int index, uint16_t blockid);
+
+    // Decode every block into out (must hold size() elements)
+    void unpack(uint16_t* out) const;
+    // Decode the blocks [first, first + count) into out
+    void unpack(uint16_t* out, int first, int count) const;
+
+    // Drops unused palette entries and shrinks the indices to the smallest width
+    void compact();
+
+    // Appends the palette and packed indices to out, read() restores them
+    // and returns false if the data is invalid for this storage size
+    void serialize(std::vector<uint8_t>& out) const;
+    bool deserialize(const uint8_t* data, size_t size);
+
+    bool     isUniform() const;
+    uint16_t getUniformBlock() const;
+
+    // Number of blocks with blockid
+    int      count(uint16_t blockid) const;
+    bool     contains(uint16_t blockid) const;
+
+    int    size() const;
+    int    getBitsPerBlock() const;
+    int    getPaletteSize() const;
+    size_t getMemoryUsage() const;
+
+private:
+    std::vector<uint16_t> m_palette;
+    std::vector<uint64_t> m_data;
+    std::vector<uint32_t> m_counts;     // Blocks using each palette entry
+
+    int      m_size;
+    int      m_bits;
+    int      m_bitsLog2;
+    uint64_t m_mask;
+
+    int  paletteIndex(uint16_t blockid);
+    static int bitsFor(size_t paletteSize);
+    void resize(int bits);
+
+    uint64_t getIndex(int index) const;
+    void     setIndex(int index, uint64_t value);
+};
@@ -1,20 +1,51 @@
 #include "chunk.h"
 
 #include "blocks.h"
+#include "chunktable.h"
 
+#include <algorithm>
+#include <cstring>
+
+// By default the chunk is empty with AIR blocks
 Chunk::Chunk(glm::vec3 position, glm::uvec3 size, gl::TextureAtlas* atlas)
-    : m_atlas(atlas)
+    : m_blocks(std::make_shared<BlockStorage>(size.x * size.y * size.z, Blocks::AIR))
+    , m_occupancy(std::make_shared<OccupancyMask>(size))
+    , m_blocksShared(false)
+    , m_layout(&ChunkLayout::get(size))
+    , m_table(nullptr)
+    , m_atlas(atlas)
+    , m_resident(true)
+    , m_dirtySections(0)
+    , m_lastAccess(0)
+    , m_version(0)
 {
-    chunk.position = position;
-    chunk.texture.texture = atlas->texture.texture;
+    m_position = position;
     m_size = size;
+}
+
+void Chunk::reset(glm::vec3 position, glm::uvec3 size)
+{
+    m_position = position;
+
+    if (size != m_size)
+    {
+        m_size = size;
+        m_layout = &ChunkLayout::get(size);
+        m_blocks = std::make_shared<BlockStorage>(size.x * size.y * size.z, Blocks::AIR);
+        m_occupancy = std::make_shared<OccupancyMask>(size);
+        m_blocksShared = false;
+    }
+    else
+        clearBlocks();
 
+    m_edits.clear();
     for (int i = 0; i < 6; i++)
-        m_neighbours[i] = nullptr;
+        m_neighbours[i] = ChunkHandle();
 
-    // By default the chunk is empty with AIR blocks
-    for (int i = 0; i < (int)(size.x * size.y * size.z); i++)
-        m_blocks.push_back(Blocks::AIR);
+    m_resident = true;
+    m_dirtySections = 0;
+    m_lastAccess = 0;
+    m_version++;
 }
 
 void Chunk::setBlockLocal(int x, int y, int z, int blockid)
@@ -27,7 +58,11 @@ void Chunk::setBlockLocal(int x, int y, int z, int blockid)
         return;
     }
     else
-        m_blocks[index3d(x, y, z)] = blockid;
+    {
+        writeBlocks().set(index3d(x, y, z), (uint16_t)blockid);
+        m_occupancy->set(x, y, z, blockid != Blocks::AIR);
+        m_version++;
+    }
 }
 
 int Chunk::getBlockLocal(int x, int y, int z)
@@ -40,133 +75,679 @@ int Chunk::getBlockLocal(int x, int y, int z)
         return -1;
     }
     else
-        return m_blocks[index3d(x, y, z)];
+        return m_blocks->get(index3d(x, y, z));
 }
 
 void Chunk::Update()
 {
-    generateMesh();
+    // Called directly instead of through the remesh queue the whole chunk is meshed
+    const uint32_t sections = (m_dirtySections != 0) ? m_dirtySections : ALL_SECTIONS;
+    m_dirtySections = 0;
+    generateMesh(sections);
 }
 
 void Chunk::UpdateNeighbours()
 {
     // Update all of the neighbours
     for (int i = 0; i < 6; i++)
-        if (m_neighbours[i] != nullptr)
-            m_neighbours[i]->Update();
+    {
+        Chunk* neighbour = residentNeighbour((NEIGHBOUR)i);
+        if (neighbour != nullptr)
+            neighbour->Update();
+    }
+}
+
+bool Chunk::markDirty(uint32_t sections)
+{
+    const bool queued = m_dirtySections != 0;
+    m_dirtySections |= sections;
+    return !queued && sections != 0;
+}
+
+bool Chunk::isDirty() const
+{
+    return m_dirtySections != 0;
+}
+
+uint32_t Chunk::getDirtySections() const
+{
+    return m_dirtySections;
+}
+
+int Chunk::getSectionHeight() const
+{
+    return std::max(SECTION_HEIGHT, ((int)m_size.y + 31) / 32);
+}
+
+int Chunk::getSectionCount() const
+{
+    const int height = getSectionHeight();
+    return ((int)m_size.y + height - 1) / height;
+}
+
+uint32_t Chunk::getSections(int yMin, int yMax) const
+{
+    yMin = std::max(yMin, 0);
+    yMax = std::min(yMax, (int)m_size.y);
+    if (yMin >= yMax)
+        return 0;
+
+    const int height = getSectionHeight();
+    const int first = yMin / height;
+    const int last = (yMax - 1) / height;
+
+    const uint32_t upToLast = (last == 31) ? ALL_SECTIONS : (1u << (last + 1)) - 1;
+    return upToLast & ~((1u << first) - 1);
+}
+
+uint8_t Chunk::getBorders(const glm::ivec3& min, const glm::ivec3& max) const
+{
+    uint8_t borders = 0;
+    if (min.x <= 0)               borders |= 1 << EAST;
+    if (max.x >= (int)m_size.x)   borders |= 1 << WEST;
+    if (min.y <= 0)               borders |= 1 << BELOW;
+    if (max.y >= (int)m_size.y)   borders |= 1 << ABOVE;
+    if (min.z <= 0)               borders |= 1 << NORTH;
+    if (max.z >= (int)m_size.z)   borders |= 1 << SOUTH;
+    return borders;
 }
 
 void Chunk::setNeighbour(NEIGHBOUR n, Chunk * c)
 {
-    m_neighbours[n] = c;
+    m_neighbours[n] = (c != nullptr) ? c->m_handle : ChunkHandle();
 }
 
-void Chunk::generateMesh()
+/**
+ * Desc. Returns the neighbour or nullptr if it isn't loaded (anymore)
+*/
+Chunk* Chunk::getNeighbour(NEIGHBOUR n)
 {
-    std::vector<GLfloat> temp_verticies;
-    std::vector<GLfloat> temp_textureCoords;
-    std::vector<GLuint>  temp_indicies;
+    if (m_table == nullptr)
+        return nullptr;
+
+    return m_table->get(m_neighbours[n]);
+}
+
+/**
+ * Desc. Drops the blocks and the mesh of the chunk to free memory
+ *
+ * Note. The chunk has to be filled again (generated or loaded) and
+ * marked resident with setResident() before it can be used
+*/
+void Chunk::evict()
+{
+    // A fresh storage drops the index array, reset() would keep it around
+    m_blocks = std::make_shared<BlockStorage>(m_size.x * m_size.y * m_size.z, Blocks::AIR);
+    m_occupancy = std::make_shared<OccupancyMask>(m_size);
+    m_blocksShared = false;
+    m_edits.clear();
+    m_resident = false;
+    m_dirtySections = 0;
+
+    m_version++;
+
+    if (m_mesh != nullptr)
+        m_mesh->clear();
+}
+
+void Chunk::setResident()
+{
+    m_resident = true;
+}
+
+bool Chunk::isResident() const
+{
+    return m_resident;
+}
+
+void Chunk::touch(uint32_t frame)
+{
+    m_lastAccess = frame;
+}
+
+uint32_t Chunk::getLastAccess() const
+{
+    return m_lastAccess;
+}
+
+Chunk* Chunk::residentNeighbour(NEIGHBOUR n)
+{
+    Chunk* neighbour = getNeighbour(n);
+    if (neighbour == nullptr || !neighbour->isResident())
+        return nullptr;
+
+    return neighbour;
+}
+
+/**
+ * Desc. Returns the block storage ready to be changed
+ *
+ * Note. If the storage was handed to a BlockSnapshot it's cloned first (with the
+ * occupancy mask) so the snapshot keeps seeing the old blocks. Readers may still hold it or already have
+ * let go, we don't look at the reference count since other threads change it
+*/
+BlockStorage& Chunk::writeBlocks()
+{
+    if (m_blocksShared)
+    {
+        m_blocks = std::make_shared<BlockStorage>(*m_blocks);
+        m_occupancy = std::make_shared<OccupancyMask>(*m_occupancy);
+        m_blocksShared = false;
+    #ifdef DEBUG
+        printf("Cloned block storage of a snapshotted chunk\n");
+    #endif
+    }
+
+    return *m_blocks;
+}
+
+/**
+ * Desc. Sets every block to AIR, reuses the storage unless a snapshot got it
+*/
+void Chunk::clearBlocks()
+{
+    if (m_blocksShared)
+    {
+        m_blocks = std::make_shared<BlockStorage>(m_size.x * m_size.y * m_size.z, Blocks::AIR);
+        m_occupancy = std::make_shared<OccupancyMask>(m_size);
+        m_blocksShared = false;
+    }
+    else
+    {
+        m_blocks->reset(Blocks::AIR);
+        m_occupancy->reset(m_size);
+    }
+}
+
+/**
+ * Desc. Shrinks the block storage after a lot of blocks have been set,
+ * a chunk that ended up holding a single block type is stored as that one value
+*/
+void Chunk::compact()
+{
+    // Compacting doesn't change any block so snapshots can keep the uncompacted storage
+    if (!m_blocks->isUniform())
+        writeBlocks().compact();
+}
+
+void Chunk::recordEdit(int x, int y, int z, int blockid)
+{
+    if (x < 0 || x >= (int)m_size.x || y < 0 || y >= (int)m_size.y || z < 0 || z >= (int)m_size.z)
+        return;
+
+    m_edits[(x * m_size.y + y) * m_size.z + z] = (uint16_t)blockid;
+}
+
+bool Chunk::isModified() const
+{
+    return !m_edits.empty();
+}
+
+/*
+    Serialized layout
+    -----------------
+    uint32_t storage size
+    BlockStorage
+    Edits
+*/
+void Chunk::serialize(std::vector<uint8_t>& out) const
+{
+    size_t start = out.size();
+    out.resize(start + sizeof(uint32_t));
+
+    m_blocks->serialize(out);
+    uint32_t storageSize = (uint32_t)(out.size() - start - sizeof(uint32_t));
+    memcpy(out.data() + start, &storageSize, sizeof(storageSize));
+
+    serializeEdits(out);
+}
+
+bool Chunk::deserialize(const uint8_t* data, size_t size, ChunkLayout::Type layout)
+{
+    uint32_t storageSize;
+    if (size < sizeof(storageSize))
+        return false;
+
+    memcpy(&storageSize, data, sizeof(storageSize));
+    data += sizeof(storageSize);
+    size -= sizeof(storageSize);
+
+    if (size < storageSize || !writeBlocks().deserialize(data, storageSize))
+        return false;
+    m_version++;
+
+    // Move every block to where our layout stores it
+    const ChunkLayout& saved = ChunkLayout::get(m_size, layout);
+    if (saved.getType() != m_layout->getType())
+    {
+        std::vector<uint16_t> blocks(m_blocks->size());
+        m_blocks->unpack(blocks.data());
+        fill([&](int x, int y, int z) { return blocks[saved.index(x, y, z)]; });
+        m_blocks->compact();
+    }
+    else
+        m_occupancy->build(*m_blocks, *m_layout);
+
+    // The blocks already contain the edits, only remember them for the next save
+    m_edits.clear();
+    return readEdits(data + storageSize, size - storageSize, false);
+}
+
+/*
+    Serialized layout
+    -----------------
+    uint32_t count
+    { uint32_t key, uint16_t block } * count
+*/
+void Chunk::serializeEdits(std::vector<uint8_t>& out) const
+{
+    const size_t entrySize = sizeof(uint32_t) + sizeof(uint16_t);
+    uint32_t count = (uint32_t)m_edits.size();
+
+    size_t start = out.size();
+    out.resize(start + sizeof(count) + count * entrySize);
+
+    uint8_t* p = out.data() + start;
+    memcpy(p, &count, sizeof(count));
+    p += sizeof(count);
+
+    for (auto& edit : m_edits)
+    {
+        memcpy(p, &edit.first, sizeof(uint32_t));
+        memcpy(p + sizeof(uint32_t), &edit.second, sizeof(uint16_t));
+        p += entrySize;
+    }
+}
+
+/**
+ * Desc. Applies saved edits on top of the blocks that are currently in the chunk
+*/
+bool Chunk::deserializeEdits(const uint8_t* data, size_t size)
+{
+    return readEdits(data, size, true);
+}
+
+bool Chunk::readEdits(const uint8_t* data, size_t size, bool apply)
+{
+    const size_t entrySize = sizeof(uint32_t) + sizeof(uint16_t);
+
+    uint32_t count;
+    if (size < sizeof(count))
+        return false;
+
+    memcpy(&count, data, sizeof(count));
+    data += sizeof(count);
+    size -= sizeof(count);
+
+    if (size != count * entrySize)
+        return false;
 
-    int indicies = 0;
-    auto createFace = [&](Cube::CubeFace cubeface, int x, int y, int z)
+    for (uint32_t i = 0; i < count; i++, data += entrySize)
     {
-        auto face = Cube::getCubeFace(cubeface);
+        uint32_t key;
+        uint16_t block;
+        memcpy(&key, data, sizeof(key));
+        memcpy(&block, data + sizeof(key), sizeof(block));
 
-        for (int i = 0; i < (int)face.verticies.size() / 3; i++)
+        if (key >= m_size.x * m_size.y * m_size.z)
+            return false;
+
+        m_edits[key] = block;
+        if (apply)
         {
-            temp_verticies.push_back(face.verticies[0 + i * 3] + x);
-            temp_verticies.push_back(face.verticies[1 + i * 3] + y);
-            temp_verticies.push_back(face.verticies[2 + i * 3] + z);
+            int z = key % m_size.z;
+            int y = (key / m_size.z) % m_size.y;
+            int x = key / (m_size.z * m_size.y);
+            setBlockLocal(x, y, z, block);
         }
+    }
 
-        auto texCoords = Blocks::getTextureCoords((Blocks::BLOCK)m_blocks[index3d(x, y, z)], cubeface, *m_atlas);
-        temp_textureCoords.insert(temp_textureCoords.end(), texCoords.begin(), texCoords.end());
+    return true;
+}
 
-        temp_indicies.push_back(indicies + 0);
-        temp_indicies.push_back(indicies + 1);
-        temp_indicies.push_back(indicies + 3);
-        temp_indicies.push_back(indicies + 3);
-        temp_indicies.push_back(indicies + 1);
-        temp_indicies.push_back(indicies + 2);
-        indicies += 4;
-    };
+bool Chunk::isUniform() const
+{
+    return m_blocks->isUniform();
+}
 
-    for (int x = 0; x < (int)m_size.x; x++)
-        for (int y = 0; y < (int)m_size.y; y++)
-            for (int z = 0; z < (int)m_size.z; z++)
-            {
-                bool left = false, right = false, front = false, back = false, top = false, bottom = false;
-                if (x != 0) left = true;
-                if (y != 0) bottom = true;
-                if (z != 0) back = true;
-                if (x != m_size.x - 1) right = true;
-                if (y != m_size.y - 1) top = true;
-                if (z != m_size.z - 1) front = true;
-
-                if (m_blocks[index3d(x, y, z)] == 0)
-                    continue;
-
-                if (left)
-                    if (m_blocks[index3d(x - 1, y, z)] == 0) createFace(Cube::CubeFace::LEFT, x, y, z);
-                if (right)
-                    if (m_blocks[index3d(x + 1, y, z)] == 0) createFace(Cube::CubeFace::RIGHT, x, y, z);
-                if (bottom)
-                    if (m_blocks[index3d(x, y - 1, z)] == 0) createFace(Cube::CubeFace::BOTTOM, x, y, z);
-                if (top)
-                    if (m_blocks[index3d(x, y + 1, z)] == 0) createFace(Cube::CubeFace::TOP, x, y, z);
-                if (back)
-                    if (m_blocks[index3d(x, y, z - 1)] == 0) createFace(Cube::CubeFace::BACK, x, y, z);
-                if (front)
-                    if (m_blocks[index3d(x, y, z + 1)] == 0) createFace(Cube::CubeFace::FRONT, x, y, z);
-
-
-                // Check 1 block width with neighbouring chunks for only the outer chunk blocks
-                // Primjer:
-                // ---------
-                // - Ako gledamo recimo lijevi/WEST neighbour onda gledamo sa krajnom kockom tog
-                // - susjednog chunka, a ako recimo gledamo desno/EAST onda trebamo provjeriti s
-                // - prvom ili nultom kockom tog susjednog chunka
-                //
-                // - !left i drugi znai da su to vanjske kocke chunka tj. da nemaju susjeda na toj strani
-                if (!left && m_neighbours[EAST] != nullptr)
-                    if (m_neighbours[EAST]->getBlockLocal(m_size.x - 1, y, z) == 0) createFace(Cube::CubeFace::LEFT, x, y, z);
-                if (!right && m_neighbours[WEST] != nullptr)
-                    if (m_neighbours[WEST]->getBlockLocal(0, y, z) == 0) createFace(Cube::CubeFace::RIGHT, x, y, z);
-                if (!bottom && m_neighbours[BELOW] != nullptr)
-                    if (m_neighbours[BELOW]->getBlockLocal(x, m_size.y - 1, z) == 0) createFace(Cube::CubeFace::BOTTOM, x, y, z);
-                if (!top && m_neighbours[ABOVE] != nullptr)
-                    if (m_neighbours[ABOVE]->getBlockLocal(x, 0, z) == 0) createFace(Cube::CubeFace::TOP, x, y, z);
-                if (!back && m_neighbours[NORTH] != nullptr)
-                    if (m_neighbours[NORTH]->getBlockLocal(x, y, m_size.z - 1) == 0) createFace(Cube::CubeFace::BACK, x, y, z);
-                if (!front && m_neighbours[SOUTH] != nullptr)
-                    if (m_neighbours[SOUTH]->getBlockLocal(x, y, 0) == 0) createFace(Cube::CubeFace::FRONT, x, y, z);
-            }
+int Chunk::getUniformBlock() const
+{
+    return m_blocks->getUniformBlock();
+}
+
+int Chunk::countBlock(int blockid) const
+{
+    return m_blocks->count((uint16_t)blockid);
+}
+
+bool Chunk::contains(int blockid) const
+{
+    return m_blocks->contains((uint16_t)blockid);
+}
+
+bool Chunk::isAllSolid() const
+{
+    return !m_blocks->contains(Blocks::AIR);
+}
 
-    // Set VBO adds a new VBO to the entity
-    // so we have to use update which just changes the data.
-    // We still have to initially set them though
-    if (chunk.VBOs.empty())
+bool Chunk::hasMesh() const
+{
+    return m_mesh != nullptr && !m_mesh->empty();
+}
+
+/**
+ * Desc. Returns the memory used by the chunks blocks, edits and GPU mesh
+ *
+ * Note. Edits are estimated as the size of a map node
+*/
+size_t Chunk::getMemoryUsage() const
+{
+    const size_t editSize = sizeof(std::pair<const uint32_t, uint16_t>) + 4 * sizeof(void*);
+    const size_t meshSize = (m_mesh != nullptr) ? m_mesh->getMemoryUsage() : 0;
+    return sizeof(Chunk) + m_blocks->getMemoryUsage() + m_occupancy->getMemoryUsage() + m_edits.size() * editSize + meshSize;
+}
+
+/**
+ * Desc. Rebuilds and uploads the given sections of the mesh
+ *
+ * Note. A mesh that was cleared or just given to the chunk has no sections yet,
+ * those are built as well
+*/
+void Chunk::generateMesh(uint32_t sections)
+{
+    // Chunks outside of the render distance don't have a mesh to build
+    if (m_mesh == nullptr)
+        return;
+
+    // Empty or buried chunks have no faces, don't create or fill any buffers for them
+    if (canSkipMesh())
     {
-        chunk.setVBO(temp_verticies, 0, 3);
-        chunk.setVBO(temp_textureCoords, 1, 2);
+        m_mesh->clear();
+        return;
     }
-    else
+
+    const int count = getSectionCount();
+    const int height = getSectionHeight();
+    sections |= m_mesh->getMissingSections(count);
+    if (count < 32)
+        sections &= (1u << count) - 1;
+
+    // Meshing only happens on the main thread so the scratch buffers are shared by
+    // every chunk, once they have grown to the biggest mesh remeshing doesn't allocate
+    static ChunkSnapshot         snapshot;
+    static std::vector<MeshData> meshes;
+    meshes.resize(count);
+
+    for (int section = 0; section < count; section++)
     {
-        chunk.updateVBO(0, temp_verticies, 0, 3);
-        chunk.updateVBO(1, temp_textureCoords, 1, 2);
+        if (!(sections & (1u << section)))
+            continue;
+
+        const int yMin = section * height;
+        takeSnapshot(snapshot, yMin, std::min(yMin + height, (int)m_size.y));
+        ChunkMesher::build(snapshot, (int)m_atlas->TEX_PER_ROW, meshes[section]);
     }
-    chunk.setEBO(temp_indicies);
+
+    m_mesh->upload(meshes, sections, m_version);
 
     #ifdef DEBUG
-        printf("Chunk Verticies: %d\n", temp_verticies.size());
-        printf("VBOs: %d\n\n", chunk.VBOs.size());
+        printf("Chunk Quads: %zu\n", m_mesh->getQuadCount());
+        printf("VBOs: %zu\n", m_mesh->entity.VBOs.size());
+        printf("Block storage: %d bits per block, %d palette entries, %d bytes\n\n",
+            m_blocks->getBitsPerBlock(), m_blocks->getPaletteSize(), (int)m_blocks->getMemoryUsage());
     #endif
 }
 
+/**
+ * Desc. Returns an immutable view of the current blocks
+ *
+ * Note. Only a reference count is bumped, the next write to the chunk
+ * clones the storage while the snapshot is alive
+*/
+BlockSnapshot Chunk::snapshotBlocks() const
+{
+    m_blocksShared = true;
+    return borrowBlocks();
+}
+
+BlockSnapshot Chunk::borrowBlocks() const
+{
+    BlockSnapshot snapshot;
+    snapshot.storage = m_blocks;
+    snapshot.occupancy = m_occupancy;
+    snapshot.layout = m_layout;
+    snapshot.version = m_version;
+    return snapshot;
+}
+
+/**
+ * Desc. Copies the blocks and the border blocks of the resident neighbours into out
+*/
+void Chunk::takeSnapshot(ChunkSnapshot& out)
+{
+    takeSnapshot(out, 0, (int)m_size.y);
+}
+
+void Chunk::takeSnapshot(ChunkSnapshot& out, int yMin, int yMax)
+{
+    BlockSnapshot neighbours[6];
+    for (int i = 0; i < 6; i++)
+    {
+        Chunk* neighbour = residentNeighbour((NEIGHBOUR)i);
+        if (neighbour != nullptr)
+            neighbours[i] = neighbour->borrowBlocks();
+    }
+
+    // The blocks are copied out before we return, nothing has to be cloned for it
+    buildSnapshot(borrowBlocks(), neighbours, out, yMin, yMax);
+}
+
+/**
+ * Desc. Fills out with the blocks of a chunk and the borders of its neighbours
+ *
+ * Note. Nothing but the snapshots is read, every chunk may be edited meanwhile
+*/
+void Chunk::buildSnapshot(const BlockSnapshot& blocks, const BlockSnapshot neighbours[6], ChunkSnapshot& out)
+{
+    buildSnapshot(blocks, neighbours, out, 0, (int)blocks.layout->getSize().y);
+}
+
+/**
+ * Desc. Fills out with the rows [yMin, yMax) of a chunk and the borders of its neighbours
+ *
+ * Note. The apron above and below a section is the next row of the chunk itself,
+ * only the first and the last section get a row of the neighbour below and above
+*/
+void Chunk::buildSnapshot(const BlockSnapshot& blocks, const BlockSnapshot neighbours[6], ChunkSnapshot& out, int yMin, int yMax)
+{
+    const ChunkLayout& layout = *blocks.layout;
+    const glm::ivec3 chunkSize = glm::ivec3(layout.getSize());
+    const glm::ivec3 size(chunkSize.x, yMax - yMin, chunkSize.z);
+    out.resize(size);
+    out.origin = glm::ivec3(0, yMin, 0);
+    out.version = blocks.version;
+
+    // Rows of the chunk in the snapshot, apron included
+    const int rowMin = std::max(yMin - 1, 0);
+    const int rowMax = std::min(yMax + 1, chunkSize.y);
+    const int rows = rowMax - rowMin;
+
+    if (layout.getType() == ChunkLayout::LINEAR)
+    {
+        // Rows along z are contiguous in both and so are the rows of one x,
+        // only the blocks that are copied get decoded
+        static thread_local std::vector<uint16_t> unpacked;
+        unpacked.resize(rows * size.z);
+        for (int x = 0; x < size.x; x++)
+        {
+            blocks.storage->unpack(unpacked.data(), layout.index(x, rowMin, 0), rows * size.z);
+            for (int y = rowMin; y < rowMax; y++)
+                memcpy(&out.blocks[out.index(x, y - yMin, 0)], &unpacked[(y - rowMin) * size.z], size.z * sizeof(uint16_t));
+        }
+    }
+    else
+    {
+        // The rows are spread over the whole storage, only their blocks are looked up
+        // instead of decoding the chunk for every section
+        const BlockStorage& storage = *blocks.storage;
+        for (int x = 0; x < size.x; x++)
+            for (int y = rowMin; y < rowMax; y++)
+            {
+                uint16_t* row = &out.blocks[out.index(x, y - yMin, 0)];
+                for (int z = 0; z < size.z; z++)
+                    row[z] = storage.get(layout.index(x, y, z));
+            }
+    }
+
+    // Evicted neighbours have no blocks, their side is left as NO_NEIGHBOUR like missing ones
+    const BlockSnapshot* neighbour;
+    if (!(neighbour = &neighbours[EAST])->empty())
+        for (int y = 0; y < size.y; y++)
+            for (int z = 0; z < size.z; z++)
+                out.blocks[out.index(-1, y, z)] = neighbour->get(chunkSize.x - 1, yMin + y, z);
+    if (!(neighbour = &neighbours[WEST])->empty())
+        for (int y = 0; y < size.y; y++)
+            for (int z = 0; z < size.z; z++)
+                out.blocks[out.index(size.x, y, z)] = neighbour->get(0, yMin + y, z);
+    if (yMin == 0 && !(neighbour = &neighbours[BELOW])->empty())
+        for (int x = 0; x < size.x; x++)
+            for (int z = 0; z < size.z; z++)
+                out.blocks[out.index(x, -1, z)] = neighbour->get(x, chunkSize.y - 1, z);
+    if (yMax == chunkSize.y && !(neighbour = &neighbours[ABOVE])->empty())
+        for (int x = 0; x < size.x; x++)
+            for (int z = 0; z < size.z; z++)
+                out.blocks[out.index(x, size.y, z)] = neighbour->get(x, 0, z);
+    if (!(neighbour = &neighbours[NORTH])->empty())
+        for (int x = 0; x < size.x; x++)
+            for (int y = 0; y < size.y; y++)
+                out.blocks[out.index(x, y, -1)] = neighbour->get(x, yMin + y, chunkSize.z - 1);
+    if (!(neighbour = &neighbours[SOUTH])->empty())
+        for (int x = 0; x < size.x; x++)
+            for (int y = 0; y < size.y; y++)
+                out.blocks[out.index(x, y, size.z)] = neighbour->get(x, yMin + y, 0);
+
+    buildSnapshotRows(blocks, neighbours, out, rowMin, rowMax);
+}
+
+/**
+ * Desc. Copies the occupancy rows of the snapshot and the x and y apron from the masks
+ *
+ * Note. Only done if a row fits into one word and every snapshot has its mask,
+ * otherwise the rows stay empty. Missing neighbours are solid like NO_NEIGHBOUR
+*/
+void Chunk::buildSnapshotRows(const BlockSnapshot& blocks, const BlockSnapshot neighbours[6], ChunkSnapshot& out, int rowMin, int rowMax)
+{
+    const glm::ivec3 chunkSize = glm::ivec3(blocks.layout->getSize());
+    if (chunkSize.z > 64 || blocks.occupancy == nullptr)
+        return;
+    for (int i = 0; i < 6; i++)
+        if (!neighbours[i].empty() && neighbours[i].occupancy == nullptr)
+            return;
+
+    const int yMin = out.origin.y;
+    const int yMax = yMin + out.size.y;
+    const uint64_t missing = OccupancyMask::fullRow(chunkSize.z);
+    auto rowOf = [&](const BlockSnapshot& snapshot, int x, int y)
+    {
+        return snapshot.empty() ? missing : snapshot.occupancy->getRowWord(x, y);
+    };
+
+    // The corners of the apron don't touch the chunk and stay 0
+    out.rows.assign((out.size.x + 2) * (out.size.y + 2), 0);
+    for (int x = 0; x < out.size.x; x++)
+        for (int y = rowMin; y < rowMax; y++)
+            out.rows[out.rowIndex(x, y - yMin)] = blocks.occupancy->getRowWord(x, y);
+
+    for (int y = 0; y < out.size.y; y++)
+    {
+        out.rows[out.rowIndex(-1, y)] = rowOf(neighbours[EAST], chunkSize.x - 1, yMin + y);
+        out.rows[out.rowIndex(out.size.x, y)] = rowOf(neighbours[WEST], 0, yMin + y);
+    }
+    if (yMin == 0)
+        for (int x = 0; x < out.size.x; x++)
+            out.rows[out.rowIndex(x, -1)] = rowOf(neighbours[BELOW], x, chunkSize.y - 1);
+    if (yMax == chunkSize.y)
+        for (int x = 0; x < out.size.x; x++)
+            out.rows[out.rowIndex(x, out.size.y)] = rowOf(neighbours[ABOVE], x, 0);
+}
+
+/**
+ * Desc. Checks if the chunk can't produce any faces
+ *
+ * Note. Faces only exist between a solid block and AIR. A chunk of AIR never
+ * has faces and a chunk without AIR is buried if none of its neighbours has AIR,
+ * both are answered by the block counts without looking at a single block
+*/
+bool Chunk::canSkipMesh()
+{
+    const int air = m_blocks->count(Blocks::AIR);
+    if (air == m_blocks->size())
+        return true;
+    if (air > 0)
+        return false;
+
+    for (int i = 0; i < 6; i++)
+    {
+        Chunk* neighbour = residentNeighbour((NEIGHBOUR)i);
+        if (neighbour != nullptr && neighbour->contains(Blocks::AIR))
+            return false;
+    }
+
+    return true;
+}
+
+const OccupancyMask& Chunk::getOccupancy() const
+{
+    return *m_occupancy;
+}
+
+const ChunkLayout& Chunk::getLayout() const
+{
+    return *m_layout;
+}
+
+glm::vec3 Chunk::getPosition() const
+{
+    return m_position;
+}
+
+uint32_t Chunk::getVersion() const
+{
+    return m_version;
+}
+
+ChunkMesh* Chunk::getMesh()
+{
+    return m_mesh.get();
+}
+
+/**
+ * Desc. Gives the chunk a mesh, Update() has to be called to build it
+*/
+void Chunk::setMesh(std::unique_ptr<ChunkMesh> mesh)
+{
+    m_mesh = std::move(mesh);
+    if (m_mesh != nullptr)
+        m_mesh->reset(m_position);
+}
+
+std::unique_ptr<ChunkMesh> Chunk::takeMesh()
+{
+    return std::move(m_mesh);
+}
+
+void Chunk::setHandle(ChunkTable* table, ChunkHandle handle)
+{
+    m_table = table;
+    m_handle = handle;
+}
+
+ChunkHandle Chunk::getHandle() const
+{
+    return m_handle;
+}
+
 int Chunk::index3d(int x, int y, int z)
 {
-    // Index = ((x * YSIZE + y) * ZSIZE) + z;
-    int h = m_size.y;
-    int d = m_size.z;
-    return ((x * h + y) * d) + z;
+    return m_layout->index(x, y, z);
 }
\ No newline at end of file
@@ -1,10 +1,42 @@
 #pragma once
 #include <cstdint>
+#include <map>
 #include <memory>
 #include <vector>
 #include <glm/glm.hpp>
 #include "../gl/glObjects.h"
-#include "../util/entity.h"
+#include "blocks.h"
+#include "blockstorage.h"
+#include "chunklayout.h"
+#include "chunkmesh.h"
+#include "chunkmesher.h"
+#include "chunksnapshot.h"
+#include "occupancymask.h"
+
+class ChunkTable;
+
+// Generational handle of a chunk in a ChunkTable, see chunktable.h
+struct ChunkHandle
+{
+    uint32_t index = UINT32_MAX;
+    uint32_t generation = 0;
+
+    bool operator==(const ChunkHandle& other) const { return index == other.index && generation == other.generation; }
+    bool operator!=(const ChunkHandle& other) const { return !(*this == other); }
+};
+
+// Immutable view of a chunks blocks at one version, see Chunk::snapshotBlocks()
+// Note. Holding one keeps the storage alive, the chunk clones it on its next write
+struct BlockSnapshot
+{
+    std::shared_ptr<const BlockStorage> storage; // nullptr if the chunk had no blocks (evicted or missing)
+    std::shared_ptr<const OccupancyMask> occupancy; // Solid bits of the same blocks
+    const ChunkLayout*                  layout = nullptr;
+    uint32_t                            version = 0;
+
+    bool empty() const { return storage == nullptr; }
+    int  get(int x, int y, int z) const { return storage->get(layout->index(x, y, z)); }
+};
 
 enum NEIGHBOUR
 {
@@ -16,31 +48,214 @@ enum NEIGHBOUR
     BELOW   = 5
 };
 
+/*
+    Chunk
+    -----
+    The blocks of a chunk and its links to the neighbouring chunks, nothing in here
+    needs a GL context. The GPU buffers live in a separate ChunkMesh that only chunks
+    inside of the render distance get through setMesh().
+
+    The block storage is copy on write. snapshotBlocks() hands out a reference to the
+    current storage which other threads can read for as long as they like. A storage
+    that was handed out is never written again, the first write after a snapshot
+    clones it and keeps editing the clone in place. Whether a snapshot was taken is
+    tracked by the chunk itself, so it doesn't depend on when readers let go of
+    their reference.
+*/
 class Chunk
 {
 public:
+    // Bits of NEIGHBOUR, see getBorders()
+    static constexpr uint8_t ALL_BORDERS = 0x3F;
+
+    // The mesh is split along y into sections that are rebuilt on their own so an edit only
+    // remeshes the few blocks around it. Sets of sections are bitmasks, see getSections()
+    static constexpr int      SECTION_HEIGHT = 8;
+    static constexpr uint32_t ALL_SECTIONS = 0xFFFFFFFF;
+
     Chunk(glm::vec3 position, glm::uvec3 size, gl::TextureAtlas* atlas);
 
+    // Turns the chunk into an empty chunk at position so it can be reused,
+    // the block and GL buffers are kept
+    void reset(glm::vec3 position, glm::uvec3 size);
+
     void setBlockLocal(int x, int y, int z, int blockid);
     int  getBlockLocal(int x, int y, int z);
 
+    // No bounds check, the caller makes sure the position is inside of the chunk
+    int  getBlockUnchecked(int x, int y, int z) const { return m_blocks->get(m_layout->index(x, y, z)); }
+    bool isSolidUnchecked(int x, int y, int z) const { return m_occupancy->isSolid(x, y, z); }
+
+    // Solid (not AIR) bit of every block, kept in sync with the blocks
+    const OccupancyMask& getOccupancy() const;
+
     void Update();
     void UpdateNeighbours();
 
-    void setNeighbour(NEIGHBOUR n, Chunk* c);
+    // A dirty chunk is remeshed by the ChunkManager at the end of the frame, Update() clears it
+    // and only rebuilds the dirty sections. markDirty() returns false if the chunk was dirty already
+    bool     markDirty(uint32_t sections = ALL_SECTIONS);
+    bool     isDirty() const;
+    uint32_t getDirtySections() const;
+
+    // Height of a section, SECTION_HEIGHT unless the chunk is too high for 32 of them
+    int      getSectionHeight() const;
+    int      getSectionCount() const;
+    // Sections that hold any of the rows [yMin, yMax), rows outside of the chunk are ignored
+    uint32_t getSections(int yMin, int yMax) const;
+
+    // Bits of the NEIGHBOUR sides the local box [min, max) touches, only the neighbours
+    // on those sides can see a change inside of the box
+    uint8_t getBorders(const glm::ivec3& min, const glm::ivec3& max) const;
+
+    void   setNeighbour(NEIGHBOUR n, Chunk* c);
+    Chunk* getNeighbour(NEIGHBOUR n);
+
+    void compact();
+
+    // Blocks changed by the player, saved as a delta on top of the generated terrain
+    void recordEdit(int x, int y, int z, int blockid);
+    bool isModified() const;
+
+    // Full payload is the block storage followed by the edits, the storage is in the
+    // chunks layout so data saved with another layout has to say which one it used
+    void serialize(std::vector<uint8_t>& out) const;
+    bool deserialize(const uint8_t* data, size_t size, ChunkLayout::Type layout = ChunkLayout::DEFAULT);
+    void serializeEdits(std::vector<uint8_t>& out) const;
+    bool deserializeEdits(const uint8_t* data, size_t size);
+
+    // Eviction, a chunk that isn't resident has no blocks or mesh
+    void     evict();
+    void     setResident();
+    bool     isResident() const;
+    void     touch(uint32_t frame);
+    uint32_t getLastAccess() const;
+
+    bool isUniform() const;
+    int  getUniformBlock() const;
+
+    // Answered from the block counts of the palette, no block is read
+    int  countBlock(int blockid) const;
+    bool contains(int blockid) const;
+    bool isAllSolid() const;
+    bool hasMesh() const;
+
+    size_t getMemoryUsage() const;
+
+    const ChunkLayout& getLayout() const;
+
+    // Cheap immutable view of the current blocks that can be read from any thread
+    BlockSnapshot snapshotBlocks() const;
+
+    // Copies the blocks and the neighbours borders so they can be meshed without the chunk,
+    // with a row range only the rows [yMin, yMax) are copied (the snapshot of a section)
+    void takeSnapshot(ChunkSnapshot& out);
+    void takeSnapshot(ChunkSnapshot& out, int yMin, int yMax);
+
+    // Same as takeSnapshot() but only reads the given snapshots so it can run on any thread,
+    // neighbours are indexed by NEIGHBOUR and empty ones are left as NO_NEIGHBOUR
+    static void buildSnapshot(const BlockSnapshot& blocks, const BlockSnapshot neighbours[6], ChunkSnapshot& out);
+    static void buildSnapshot(const BlockSnapshot& blocks, const BlockSnapshot neighbours[6], ChunkSnapshot& out, int yMin, int yMax);
+
+    // Sets every block to blockAt(x, y, z), the blocks are visited in storage order
+    template<typename F>
+    void fill(F&& blockAt)
+    {
+        BlockStorage& blocks = writeBlocks();
+        const int count = m_layout->getCount();
+        for (int i = 0; i < count; i++)
+        {
+            glm::ivec3 p = m_layout->position(i);
+            blocks.set(i, (uint16_t)blockAt(p.x, p.y, p.z));
+        }
+        m_occupancy->build(blocks, *m_layout);
+        m_version++;
+    }
+
+    // Calls blockAt(x, y, z, block) for every block in [min, max) and sets the block to what it
+    // returns, -1 keeps the block. Changed blocks are recorded as edits, returns how many changed
+    template<typename F>
+    int editBox(const glm::ivec3& min, const glm::ivec3& max, F&& blockAt)
+    {
+        // Only take the storage for writing once something changes so snapshots aren't cloned for nothing
+        BlockStorage* blocks = nullptr;
+        int changed = 0;
+
+        for (int x = min.x; x < max.x; x++)
+            for (int y = min.y; y < max.y; y++)
+                for (int z = min.z; z < max.z; z++)
+                {
+                    const int i = m_layout->index(x, y, z);
+                    const int current = m_blocks->get(i);
+                    const int block = blockAt(x, y, z, current);
+                    if (block < 0 || block == current)
+                        continue;
+
+                    if (blocks == nullptr)
+                        blocks = &writeBlocks();
+                    blocks->set(i, (uint16_t)block);
+                    m_occupancy->set(x, y, z, block != Blocks::AIR);
+                    m_edits[(x * m_size.y + y) * m_size.z + z] = (uint16_t)block;
+                    changed++;
+                }
+
+        if (changed > 0)
+            m_version++;
+        return changed;
+    }
+
+    glm::vec3 getPosition() const;
+
+    // Changes every time the blocks change, meshes and snapshots remember the version they were made from
+    uint32_t getVersion() const;
+
+    ChunkMesh*                 getMesh();
+    void                       setMesh(std::unique_ptr<ChunkMesh> mesh);
+    std::unique_ptr<ChunkMesh> takeMesh();
+
+    // Set by the ChunkTable that owns the chunk, neighbours are resolved through it
+    void        setHandle(ChunkTable* table, ChunkHandle handle);
+    ChunkHandle getHandle() const;
 
-    Entity chunk;
 private:
-    std::vector<uint8_t>    m_blocks;
+    // Shared with the BlockSnapshots taken since the last write, the occupancy
+    // mask is copied on write together with the blocks
+    std::shared_ptr<BlockStorage> m_blocks;
+    std::shared_ptr<OccupancyMask> m_occupancy;
+    // Set once m_blocks was handed to a BlockSnapshot, the next write clones it
+    mutable bool            m_blocksShared;
+    glm::vec3               m_position;
     glm::uvec3              m_size;
+    const ChunkLayout*      m_layout;
+
+    // Keyed by ((x * YSIZE + y) * ZSIZE) + z so saves don't depend on the block layout
+    std::map<uint32_t, uint16_t> m_edits;
 
-    Chunk*                  m_neighbours[6];
+    ChunkTable*             m_table;
+    ChunkHandle             m_handle;
+    ChunkHandle             m_neighbours[6];
 
     gl::TextureAtlas*       m_atlas;
 
-    void generateMesh();
+    bool                    m_resident;
+    uint32_t                m_dirtySections;
+    uint32_t                m_lastAccess;
+    uint32_t                m_version;
+
+    std::unique_ptr<ChunkMesh> m_mesh;
+
+    Chunk* residentNeighbour(NEIGHBOUR n);
+
+    BlockStorage& writeBlocks();
+    void          clearBlocks();
+    // View of the blocks that doesn't outlive the caller, the storage isn't marked as shared
+    BlockSnapshot borrowBlocks() const;
+    static void   buildSnapshotRows(const BlockSnapshot& blocks, const BlockSnapshot neighbours[6], ChunkSnapshot& out, int rowMin, int rowMax);
+
+    bool readEdits(const uint8_t* data, size_t size, bool apply);
+
+    void generateMesh(uint32_t sections);
+    bool canSkipMesh();
 
     int index3d(int x, int y, int z);
 };
-
-typedef std::shared_ptr<Chunk> ChunkRef;
\ No newline at end of file
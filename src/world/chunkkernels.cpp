@@ -0,0 +1,285 @@
+#include "chunkkernels.h"
+
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define CHUNK_KERNELS_AVX2
+#include <immintrin.h>
+#endif
+
+// The row helpers have to end up inlined into the kernels, the AVX2 ones can't be
+// inlined into a function that isn't compiled for AVX2 so the kernels are flattened
+#ifdef _MSC_VER
+#include <intrin.h>
+#define KERNEL_INLINE __forceinline
+#define KERNEL_FLATTEN
+#define KERNEL_AVX2
+#else
+#define KERNEL_INLINE inline
+#define KERNEL_FLATTEN __attribute__((flatten))
+#define KERNEL_AVX2 __attribute__((target("avx2")))
+#endif
+
+namespace
+{
+    // Byte i is bit i of the index, for unpacking 8 bits of a row at a time
+    struct SpreadTable
+    {
+        uint64_t bytes[256];
+
+        SpreadTable()
+        {
+            for (int bits = 0; bits < 256; bits++)
+            {
+                bytes[bits] = 0;
+                for (int i = 0; i < 8; i++)
+                    bytes[bits] |= (uint64_t)((bits >> i) & 1) << (i * 8);
+            }
+        }
+    };
+
+    const SpreadTable spread;
+
+    // Unpacking of the rows with plain integers
+    template<int SZ>
+    struct ScalarRows
+    {
+        // Writes the face bits of the row into one mask byte per block
+        static KERNEL_INLINE void unpack(const uint64_t faces[6], uint8_t* masks)
+        {
+            for (int z = 0; z < SZ; z += 8)
+            {
+                uint64_t bytes = 0;
+                for (int face = 0; face < 6; face++)
+                    bytes |= spread.bytes[(faces[face] >> z) & 0xFF] << face;
+
+                // Byte order of the table is little endian like the CPUs we run on
+                std::memcpy(masks + z, &bytes, 8);
+            }
+        }
+    };
+
+#ifdef CHUNK_KERNELS_AVX2
+    // Same with AVX2, 16 or 32 blocks per instruction. Rows are at least 16 long
+    template<int SZ>
+    struct Avx2Rows
+    {
+        static KERNEL_AVX2 KERNEL_INLINE void unpack(const uint64_t faces[6], uint8_t* masks)
+        {
+            // Byte i gets byte i / 8 of the word, then every byte tests its own bit
+            const __m256i shuffle = _mm256_setr_epi8(0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1,
+                                                     2, 2, 2, 2, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 3, 3);
+            const __m256i select = _mm256_set1_epi64x((long long)0x8040201008040201ULL);
+
+            constexpr int STEP = SZ < 32 ? SZ : 32;
+            for (int z = 0; z < SZ; z += STEP)
+            {
+                __m256i bytes = _mm256_setzero_si256();
+                for (int face = 0; face < 6; face++)
+                {
+                    __m256i word = _mm256_shuffle_epi8(_mm256_set1_epi32((int)(uint32_t)(faces[face] >> z)), shuffle);
+                    __m256i set  = _mm256_cmpeq_epi8(_mm256_and_si256(word, select), select);
+                    bytes = _mm256_or_si256(bytes, _mm256_and_si256(set, _mm256_set1_epi8((char)(1 << face))));
+                }
+
+                if constexpr (STEP == 32)
+                    _mm256_storeu_si256((__m256i*)(masks + z), bytes);
+                else
+                    _mm_storeu_si128((__m128i*)(masks + z), _mm256_castsi256_si128(bytes));
+            }
+        }
+    };
+#endif
+
+    /**
+     * Desc. Face masks of a chunk from the occupancy bits of its rows along z
+     *
+     * Note. The rows come from the occupancy masks (ChunkSnapshot::rows), the apron
+     * included so the faces at the chunk borders come out of the same masks. The blocks
+     * past both ends of a row are read from padded since a 64 long row fills the word
+    */
+    template<int LOG_X, int LOG_Y, int LOG_Z, class Rows>
+    KERNEL_INLINE void faceMasks(const uint16_t* padded, const uint64_t* rows, uint8_t* masks)
+    {
+        static_assert(LOG_Z <= 6, "a row along z has to fit into a 64-bit word");
+
+        constexpr int SX = 1 << LOG_X;
+        constexpr int SY = 1 << LOG_Y;
+        constexpr int SZ = 1 << LOG_Z;
+        constexpr int STRIDE_Y = SZ + 2;
+        constexpr int STRIDE_X = (SY + 2) * STRIDE_Y;
+        constexpr int ROWS_X = SY + 2;
+
+        const int top    = (int)Cube::CubeFace::TOP;
+        const int bottom = (int)Cube::CubeFace::BOTTOM;
+        const int left   = (int)Cube::CubeFace::LEFT;
+        const int right  = (int)Cube::CubeFace::RIGHT;
+        const int back   = (int)Cube::CubeFace::BACK;
+        const int front  = (int)Cube::CubeFace::FRONT;
+
+        for (int x = 0; x < SX; x++)
+            for (int y = 0; y < SY; y++)
+            {
+                const uint64_t* row = &rows[(x + 1) * ROWS_X + (y + 1)];
+                const uint64_t solid = row[0];
+                uint8_t* m = masks + ((x << (LOG_Y + LOG_Z)) | (y << LOG_Z));
+
+                if (solid == 0)
+                {
+                    std::memset(m, 0, SZ);
+                    continue;
+                }
+
+                const uint16_t* b = padded + (x + 1) * STRIDE_X + (y + 1) * STRIDE_Y + 1;
+                const uint64_t before = (uint64_t)(b[-1] != 0);
+                const uint64_t after  = (uint64_t)(b[SZ] != 0) << (SZ - 1);
+
+                uint64_t faces[6];
+                faces[left]   = solid & ~row[-ROWS_X];
+                faces[right]  = solid & ~row[ROWS_X];
+                faces[bottom] = solid & ~row[-1];
+                faces[top]    = solid & ~row[1];
+                faces[back]   = solid & ~((solid << 1) | before);
+                faces[front]  = solid & ~((solid >> 1) | after);
+
+                // Buried rows are common underground
+                if ((faces[0] | faces[1] | faces[2] | faces[3] | faces[4] | faces[5]) == 0)
+                {
+                    std::memset(m, 0, SZ);
+                    continue;
+                }
+
+                Rows::unpack(faces, m);
+            }
+    }
+
+    template<int LOG_X, int LOG_Y, int LOG_Z>
+    KERNEL_FLATTEN void faceMasksScalar(const uint16_t* padded, const uint64_t* rows, uint8_t* masks)
+    {
+        faceMasks<LOG_X, LOG_Y, LOG_Z, ScalarRows<1 << LOG_Z>>(padded, rows, masks);
+    }
+
+#ifdef CHUNK_KERNELS_AVX2
+    template<int LOG_X, int LOG_Y, int LOG_Z>
+    KERNEL_AVX2 KERNEL_FLATTEN void faceMasksAvx2(const uint16_t* padded, const uint64_t* rows, uint8_t* masks)
+    {
+        faceMasks<LOG_X, LOG_Y, LOG_Z, Avx2Rows<1 << LOG_Z>>(padded, rows, masks);
+    }
+#define AVX2_KERNEL(LOG_X, LOG_Y, LOG_Z) faceMasksAvx2<LOG_X, LOG_Y, LOG_Z>
+#else
+#define AVX2_KERNEL(LOG_X, LOG_Y, LOG_Z) nullptr
+#endif
+
+    struct Instantiation
+    {
+        glm::uvec3                   size;
+        ChunkKernels::FaceMaskKernel faceMasks[2];  // Indexed by Isa
+    };
+
+    #define KERNELS(LOG_X, LOG_Y, LOG_Z) { faceMasksScalar<LOG_X, LOG_Y, LOG_Z>, AVX2_KERNEL(LOG_X, LOG_Y, LOG_Z) }
+
+    // Every supported chunk size, add a line here to support another one
+    const Instantiation instantiations[] = {
+        { { 16,  16, 16 }, KERNELS(4, 4, 4) },
+        { { 32,  32, 32 }, KERNELS(5, 5, 5) },
+        { { 64,  64, 64 }, KERNELS(6, 6, 6) },
+        { { 32,  64, 32 }, KERNELS(5, 6, 5) },
+        { { 16, 256, 16 }, KERNELS(4, 8, 4) },
+
+        // Mesh sections of the sizes above, see Chunk::SECTION_HEIGHT
+        { { 16,   8, 16 }, KERNELS(4, 3, 4) },
+        { { 32,   8, 32 }, KERNELS(5, 3, 5) },
+        { { 64,   8, 64 }, KERNELS(6, 3, 6) }
+    };
+
+    #undef KERNELS
+
+    bool cpuHasAvx2()
+    {
+    #if !defined(CHUNK_KERNELS_AVX2)
+        return false;
+    #elif defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 0);
+        if (info[0] < 7)
+            return false;
+
+        // The OS has to save the YMM registers too
+        __cpuid(info, 1);
+        const bool osxsave = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0;
+        if (!osxsave || (_xgetbv(0) & 6) != 6)
+            return false;
+
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+    #else
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2");
+    #endif
+    }
+
+    const ChunkKernels::Isa fastestIsa = cpuHasAvx2() ? ChunkKernels::Isa::AVX2 : ChunkKernels::Isa::SCALAR;
+    ChunkKernels::Isa currentIsa = fastestIsa;
+}
+
+ChunkKernels::Isa ChunkKernels::getIsa()
+{
+    return currentIsa;
+}
+
+void ChunkKernels::setIsa(Isa isa)
+{
+    currentIsa = isSupported(isa) ? isa : fastestIsa;
+}
+
+bool ChunkKernels::isSupported(Isa isa)
+{
+    return (int)isa <= (int)fastestIsa;
+}
+
+void ChunkKernels::faceMasks(glm::ivec3 size, const uint16_t* padded, uint8_t* masks)
+{
+    const int strideY = size.z + 2;
+    const int strideX = (size.y + 2) * strideY;
+
+    for (int x = 0; x < size.x; x++)
+        for (int y = 0; y < size.y; y++)
+        {
+            const uint16_t* b = padded + (x + 1) * strideX + (y + 1) * strideY + 1;
+            uint8_t* m = masks + (x * size.y + y) * size.z;
+
+            for (int z = 0; z < size.z; z++)
+            {
+                uint8_t mask = 0;
+                if (b[z - strideX] == 0) mask |= faceBit(Cube::CubeFace::LEFT);
+                if (b[z + strideX] == 0) mask |= faceBit(Cube::CubeFace::RIGHT);
+                if (b[z - strideY] == 0) mask |= faceBit(Cube::CubeFace::BOTTOM);
+                if (b[z + strideY] == 0) mask |= faceBit(Cube::CubeFace::TOP);
+                if (b[z - 1] == 0)       mask |= faceBit(Cube::CubeFace::BACK);
+                if (b[z + 1] == 0)       mask |= faceBit(Cube::CubeFace::FRONT);
+                m[z] = b[z] != 0 ? mask : 0;
+            }
+        }
+}
+
+ChunkKernels::FaceMaskKernel ChunkKernels::getFaceMaskKernel(glm::uvec3 size)
+{
+    return getFaceMaskKernel(size, currentIsa);
+}
+
+ChunkKernels::FaceMaskKernel ChunkKernels::getFaceMaskKernel(glm::uvec3 size, Isa isa)
+{
+    if (!isSupported(isa))
+        return nullptr;
+
+    for (auto& instantiation : instantiations)
+        if (instantiation.size == size)
+            return instantiation.faceMasks[(int)isa];
+
+    return nullptr;
+}
+
+bool ChunkKernels::isSupported(glm::uvec3 size)
+{
+    return getFaceMaskKernel(size, Isa::SCALAR) != nullptr;
+}
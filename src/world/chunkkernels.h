@@ -0,0 +1,60 @@
+#pragma once
+#include <cstdint>
+#include <glm/glm.hpp>
+#include "../util/cube.h"
+
+/*
+    Chunk kernels
+    -------------
+    Versions of the hot per block loops compiled for fixed power of two chunk sizes.
+    With the size known at compile time indexing is shifts and masks and every loop
+    has a constant trip count so the compiler can unroll and vectorize it.
+
+    The face mask kernels work on occupancy bits instead of single blocks. Every row
+    along z is a 64-bit word of solid bits taken from the chunks OccupancyMask, the
+    faces of a whole row are found with a few shifts, ANDs and NOTs against the
+    neighbouring rows:
+
+        left  = row & ~row(x - 1)       back  = row & ~(row << 1)
+        right = row & ~row(x + 1)       front = row & ~(row >> 1)
+
+    Every kernel is compiled once with plain 64-bit integers and once with AVX2 for
+    unpacking the bits into masks, the AVX2 one is used if the CPU supports it.
+
+    Only the sizes in the table in chunkkernels.cpp are instantiated,
+    ChunkManager::setChunkSize() only accepts those sizes, chunks created directly
+    with any other size are meshed with the generic version.
+*/
+namespace ChunkKernels
+{
+    // Bit (1 << CubeFace) is set if the face of the block touches AIR inside of the chunk
+    inline uint8_t faceBit(Cube::CubeFace face)
+    {
+        return (uint8_t)(1 << (int)face);
+    }
+
+    // Writes the face mask of every block into masks (x major, unpadded) from the
+    // blocks and rows of a ChunkSnapshot, the apron holds the neighbours so there are no borders
+    typedef void (*FaceMaskKernel)(const uint16_t* padded, const uint64_t* rows, uint8_t* masks);
+
+    // Instruction sets the kernels are compiled for, from slowest to fastest
+    enum class Isa
+    {
+        SCALAR, AVX2
+    };
+
+    // The instruction set the kernels use, the fastest one the CPU supports by default
+    Isa getIsa();
+    // Limits the kernels to isa, for comparing them. Sets the fastest supported one if isa isn't
+    void setIsa(Isa isa);
+    bool isSupported(Isa isa);
+
+    // Same as the kernels, one block at a time. Used for sizes without a kernel
+    void faceMasks(glm::ivec3 size, const uint16_t* padded, uint8_t* masks);
+
+    // Returns the kernel compiled for size and the current isa or nullptr if there is none
+    FaceMaskKernel getFaceMaskKernel(glm::uvec3 size);
+    FaceMaskKernel getFaceMaskKernel(glm::uvec3 size, Isa isa);
+
+    bool isSupported(glm::uvec3 size);
+};
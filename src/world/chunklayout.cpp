@@ -0,0 +1,95 @@
+#include "chunklayout.h"
+
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <tuple>
+
+const ChunkLayout& ChunkLayout::get(glm::uvec3 size, Type type)
+{
+    static std::map<std::tuple<unsigned, unsigned, unsigned, int>, std::unique_ptr<ChunkLayout>> layouts;
+
+    auto& layout = layouts[std::make_tuple(size.x, size.y, size.z, (int)type)];
+    if (layout == nullptr)
+        layout.reset(new ChunkLayout(size, type));
+
+    return *layout;
+}
+
+static bool isPowerOfTwo(unsigned value)
+{
+    return value != 0 && (value & (value - 1)) == 0;
+}
+
+ChunkLayout::ChunkLayout(glm::uvec3 size, Type type)
+    : m_type(type)
+    , m_size(size)
+{
+    if (type == MORTON && !(isPowerOfTwo(size.x) && isPowerOfTwo(size.y) && isPowerOfTwo(size.z)))
+    {
+        printf("Morton layout needs power of two chunk sizes, using the linear layout for %ux%ux%u\n", size.x, size.y, size.z);
+        m_type = type = LINEAR;
+    }
+
+    m_x.resize(size.x);
+    m_y.resize(size.y);
+    m_z.resize(size.z);
+
+    if (type == LINEAR)
+    {
+        for (unsigned x = 0; x < size.x; x++) m_x[x] = x * size.y * size.z;
+        for (unsigned y = 0; y < size.y; y++) m_y[y] = y * size.z;
+        for (unsigned z = 0; z < size.z; z++) m_z[z] = z;
+    }
+    else
+    {
+        // Hand out the index bits round robin (z, y, x) until every axis ran out of bits,
+        // with unequal sizes the longer axes simply get the remaining high bits
+        int bitsLeft[3] = { 0, 0, 0 };
+        for (unsigned s = size.z; s > 1; s >>= 1) bitsLeft[0]++;
+        for (unsigned s = size.y; s > 1; s >>= 1) bitsLeft[1]++;
+        for (unsigned s = size.x; s > 1; s >>= 1) bitsLeft[2]++;
+
+        std::vector<uint32_t>* tables[3] = { &m_z, &m_y, &m_x };
+        int bit[3] = { 0, 0, 0 };
+        int outBit = 0;
+        while (bitsLeft[0] + bitsLeft[1] + bitsLeft[2] > 0)
+        {
+            for (int axis = 0; axis < 3; axis++)
+            {
+                if (bitsLeft[axis] == 0)
+                    continue;
+
+                auto& table = *tables[axis];
+                for (uint32_t v = 0; v < table.size(); v++)
+                    if (v & (1u << bit[axis]))
+                        table[v] |= 1u << outBit;
+
+                bit[axis]++;
+                bitsLeft[axis]--;
+                outBit++;
+            }
+        }
+    }
+
+    m_positions.resize(size.x * size.y * size.z);
+    for (unsigned x = 0; x < size.x; x++)
+        for (unsigned y = 0; y < size.y; y++)
+            for (unsigned z = 0; z < size.z; z++)
+                m_positions[index(x, y, z)] = glm::u16vec3(x, y, z);
+}
+
+ChunkLayout::Type ChunkLayout::getType() const
+{
+    return m_type;
+}
+
+glm::uvec3 ChunkLayout::getSize() const
+{
+    return m_size;
+}
+
+int ChunkLayout::getCount() const
+{
+    return (int)m_positions.size();
+}
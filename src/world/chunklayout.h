@@ -0,0 +1,67 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtc/type_precision.hpp>
+
+/*
+    Chunk block layout
+    ------------------
+    Maps a local block position to its index in the chunks block storage.
+
+    LINEAR - x major, ((x * YSIZE + y) * ZSIZE) + z. Neighbours along z are next to
+             each other but neighbours along x are YSIZE * ZSIZE blocks apart
+    MORTON - Z-order curve, the bits of x, y and z are interleaved so blocks that are
+             close in any direction are close in memory. Needs power of two sizes
+
+    Both layouts are a sum of one value per axis so an index is three table lookups
+    and two adds no matter which layout is used.
+
+    The layout used by chunks is picked at compile time, build with
+    -DCHUNK_MORTON_LAYOUT to use the Morton layout.
+*/
+class ChunkLayout
+{
+public:
+    enum Type : uint8_t
+    {
+        LINEAR = 0,
+        MORTON = 1
+    };
+
+#ifdef CHUNK_MORTON_LAYOUT
+    static const Type DEFAULT = MORTON;
+#else
+    static const Type DEFAULT = LINEAR;
+#endif
+
+    // Layouts are built once per chunk size and shared by every chunk
+    static const ChunkLayout& get(glm::uvec3 size, Type type = DEFAULT);
+
+    int index(int x, int y, int z) const
+    {
+        return m_x[x] + m_y[y] + m_z[z];
+    }
+
+    // Position of the block stored at index, walking the indices in order
+    // visits the blocks in the order they are stored in
+    glm::ivec3 position(int index) const
+    {
+        return glm::ivec3(m_positions[index]);
+    }
+
+    Type       getType() const;
+    glm::uvec3 getSize() const;
+    int        getCount() const;
+
+private:
+    ChunkLayout(glm::uvec3 size, Type type);
+
+    Type                    m_type;
+    glm::uvec3              m_size;
+
+    std::vector<uint32_t>   m_x;
+    std::vector<uint32_t>   m_y;
+    std::vector<uint32_t>   m_z;
+    std::vector<glm::u16vec3> m_positions;
+};
@@ -1,16 +1,54 @@
 #include "chunkmanager.h"
 
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <filesystem>
+#include <fstream>
 #include "../util/cube.h"
 #include "../util/math.h"
 #include "blocks.h"
+#include "chunkkernels.h"
 
-ChunkManager::ChunkManager()
-    : atlas("resources/textures/textureAtlas.png", 2048, 256)
+ChunkManager::ChunkManager(gl::TextureAtlas* atlas)
+    : table(atlas)
+    , m_atlas(atlas)
 {
     // Default chunk size
     chunkSize = { 32, 32, 32 };
+
+    setTerrain(32, 96, 0);
+    setStreamingRadius(4, 2);
+    setRenderDistance(4, 2);
+    setChunksPerFrame(4);
+    setSaveMode(SaveMode::DELTA);
+    setMemoryBudget(0);
+
+    m_frame = 1;
+    m_unloadRetryFrame = 0;
+    m_unloadRetryDelay = UNLOAD_RETRY_MIN;
 }
 
+ChunkManager::~ChunkManager()
+{
+    saveAll();
+
+    for (auto chunk : chunks)
+        table.destroy(chunk->getHandle());
+    chunks.clear();
+}
+
+// Chunk coordinate offset of each neighbour and the side it sees us from
+static const ChunkPos NEIGHBOUR_OFFSETS[6] = {
+    { 0, 0,-1 },    // NORTH
+    { 0, 0, 1 },    // SOUTH
+    {-1, 0, 0 },    // EAST
+    { 1, 0, 0 },    // WEST
+    { 0, 1, 0 },    // ABOVE
+    { 0,-1, 0 }     // BELOW
+};
+static const NEIGHBOUR OPPOSITE[6] = { SOUTH, NORTH, WEST, EAST, BELOW, ABOVE };
+
 /**
  * Desc. Generate the given amount of chunks in WIDTH HEIGHT LENGTH
 */
@@ -18,63 +56,108 @@ void ChunkManager::generateChunks(int x, int y, int z)
 {
     worldSize = glm::vec3(x, y, z);
 
-    // Create the chunks
-    for (int sx = 0; sx < x; sx++)
-        for (int sy = 0; sy < y; sy++)
-            for (int sz = 0; sz < z; sz++)
-            {
-                auto temp = std::make_shared<Chunk>(glm::vec3(sx * chunkSize.x, sy * chunkSize.y, sz * chunkSize.z), chunkSize, &atlas);
-                chunks.push_back(temp);
-            }
-
-    // Set each chunks neighbours
+    // Create the chunks, neighbours are linked as they get loaded.
+    // The whole fixed size world is drawn so every chunk gets a mesh
     for (int sx = 0; sx < x; sx++)
         for (int sy = 0; sy < y; sy++)
             for (int sz = 0; sz < z; sz++)
             {
-                bool left = false, right = false, front = false, back = false, top = false, bottom = false;
-                if (sx != 0) left = true;
-                if (sy != 0) bottom = true;
-                if (sz != 0) back = true;
-                if (sx != x - 1) right = true;
-                if (sy != y - 1) top = true;
-                if (sz != z - 1) front = true;
-
-                // boolean values tell us if a given chunk can have a neighbour on that side and if it can
-                // we add a reference to that neighbour to the given chunk[x][y][z]
-                if (left)
-                    chunks[IndexFrom3D(sx, sy, sz)]->setNeighbour(EAST, chunks[IndexFrom3D(sx - 1, sy, sz)].get());
-                if (right)
-                    chunks[IndexFrom3D(sx, sy, sz)]->setNeighbour(WEST, chunks[IndexFrom3D(sx + 1, sy, sz)].get());
-                if (back)
-                    chunks[IndexFrom3D(sx, sy, sz)]->setNeighbour(NORTH, chunks[IndexFrom3D(sx, sy, sz - 1)].get());
-                if (front)
-                    chunks[IndexFrom3D(sx, sy, sz)]->setNeighbour(SOUTH, chunks[IndexFrom3D(sx, sy, sz + 1)].get());
-                if (top)
-                    chunks[IndexFrom3D(sx, sy, sz)]->setNeighbour(ABOVE, chunks[IndexFrom3D(sx, sy + 1, sz)].get());
-                if (bottom)
-                    chunks[IndexFrom3D(sx, sy, sz)]->setNeighbour(BELOW, chunks[IndexFrom3D(sx, sy - 1, sz)].get());
+                Chunk* chunk = loadChunk({ sx, sy, sz });
+                if (m_atlas != nullptr)
+                    chunk->setMesh(table.acquireMesh());
             }
 }
 
+/**
+ * Desc. Sets the size of chunks loaded from now on
+ *
+ * Note. Only sizes with compiled chunk kernels are supported (see chunkkernels.cpp),
+ * other sizes are ignored
+*/
 void ChunkManager::setChunkSize(int x, int y, int z)
 {
+    if (x <= 0 || y <= 0 || z <= 0 || !ChunkKernels::isSupported(glm::uvec3(x, y, z)))
+    {
+        printf("Chunk size %dx%dx%d isn't supported\n", x, y, z);
+        return;
+    }
+
     chunkSize = { x, y, z };
 }
 
-int ChunkManager::getBlockGlobal(int x, int y, int z)
+/**
+ * Desc. Creates an empty chunk at the given chunk coordinate and links it with its neighbours
+ *
+ * Note. If the chunk is already loaded the existing chunk is returned
+*/
+Chunk* ChunkManager::loadChunk(const ChunkPos& pos)
+{
+    Chunk* existing = chunks.get(pos);
+    if (existing != nullptr)
+        return existing;
+
+    glm::vec3 position = glm::vec3(pos) * glm::vec3(chunkSize);
+    Chunk* chunk = table.get(table.create(position, chunkSize));
+    chunks.insert(pos, chunk);
+
+    for (int i = 0; i < 6; i++)
+    {
+        Chunk* neighbour = chunks.get(pos + NEIGHBOUR_OFFSETS[i]);
+        if (neighbour == nullptr)
+            continue;
+
+        chunk->setNeighbour((NEIGHBOUR)i, neighbour);
+        neighbour->setNeighbour(OPPOSITE[i], chunk);
+    }
+
+    return chunk;
+}
+
+/**
+ * Desc. Removes the chunk at the given chunk coordinate
+ *
+ * Note. The neighbours handles to the chunk simply stop resolving, they don't need to be unlinked
+*/
+void ChunkManager::unloadChunk(const ChunkPos& pos)
 {
-    // Get the chunk from global block position
-    int cx = x / chunkSize.x;
-    int cy = y / chunkSize.y;
-    int cz = z / chunkSize.z;
+    Chunk* chunk = chunks.erase(pos);
+    if (chunk != nullptr)
+        table.destroy(chunk->getHandle());
+}
 
-    // Convert to local block position
-    int lx = x % chunkSize.x;
-    int ly = y % chunkSize.y;
-    int lz = z % chunkSize.z;
+Chunk* ChunkManager::getChunk(const ChunkPos& pos)
+{
+    return access(chunks.get(pos));
+}
 
-    if (ChunkOutOfBounds(cx, cy, cz))
+/**
+ * Desc. Converts a global(world) block position into the coordinate of the chunk containing it
+*/
+ChunkPos ChunkManager::toChunkPos(int x, int y, int z)
+{
+    return {
+        Math::floorDiv(x, chunkSize.x),
+        Math::floorDiv(y, chunkSize.y),
+        Math::floorDiv(z, chunkSize.z)
+    };
+}
+
+/**
+ * Desc. Converts a global(world) block position into the block position inside of its chunk
+*/
+glm::ivec3 ChunkManager::toLocalPos(int x, int y, int z)
+{
+    return {
+        Math::floorMod(x, chunkSize.x),
+        Math::floorMod(y, chunkSize.y),
+        Math::floorMod(z, chunkSize.z)
+    };
+}
+
+int ChunkManager::getBlockGlobal(int x, int y, int z)
+{
+    Chunk* chunk = access(chunks.get(toChunkPos(x, y, z)));
+    if (chunk == nullptr)
     {
     #ifdef DEBUG
             printf("Tried to get out of bounds chunk!\n");
@@ -82,7 +165,8 @@ int ChunkManager::getBlockGlobal(int x, int y, int z)
         return -1;
     }
 
-    return chunks.at(IndexFrom3D(cx, cy, cz))->getBlockLocal(lx, ly, lz);
+    glm::ivec3 local = toLocalPos(x, y, z);
+    return chunk->getBlockLocal(local.x, local.y, local.z);
 }
 
 /**
@@ -92,17 +176,8 @@ int ChunkManager::getBlockGlobal(int x, int y, int z)
 */
 void ChunkManager::setBlockGlobal(int x, int y, int z, int blockid)
 {
-    // Get the chunk from global block position
-    int cx = x / chunkSize.x;
-    int cy = y / chunkSize.y;
-    int cz = z / chunkSize.z;
-
-    // Convert to local block position
-    int lx = x % chunkSize.x;
-    int ly = y % chunkSize.y;
-    int lz = z % chunkSize.z;
-
-    if (ChunkOutOfBounds(cx, cy, cz))
+    Chunk* chunk = access(chunks.get(toChunkPos(x, y, z)));
+    if (chunk == nullptr)
     {
     #ifdef DEBUG
             printf("Tried to get out of bounds chunk!\n");
@@ -110,7 +185,39 @@ void ChunkManager::setBlockGlobal(int x, int y, int z, int blockid)
         return;
     }
 
-    chunks.at(IndexFrom3D(cx, cy, cz))->setBlockLocal(lx, ly, lz, blockid);
+    glm::ivec3 local = toLocalPos(x, y, z);
+    int previous = chunk->getBlockUnchecked(local.x, local.y, local.z);
+
+    // Writing the same block again would only grow the saved edits and keep the chunk modified
+    if (previous == blockid)
+        return;
+
+    chunk->setBlockLocal(local.x, local.y, local.z, blockid);
+    chunk->recordEdit(local.x, local.y, local.z, blockid);
+
+    // Neighbours only need a new mesh if the block is on their border
+    markDirty(chunk, local, local + 1);
+
+    journal.record(toChunkPos(x, y, z), local, (uint16_t)previous, (uint16_t)blockid);
+    journal.closeGroup();
+}
+
+int ChunkManager::getBlockGlobal(const glm::vec3& position)
+{
+    glm::ivec3 block = glm::floor(position);
+    return getBlockGlobal(block.x, block.y, block.z);
+}
+
+void ChunkManager::setBlockGlobal(const glm::vec3& position, int blockid)
+{
+    glm::ivec3 block = glm::floor(position);
+    setBlockGlobal(block.x, block.y, block.z, blockid);
+}
+
+Chunk* ChunkManager::getChunkFromGlobal(const glm::vec3& position)
+{
+    glm::ivec3 block = glm::floor(position);
+    return getChunkFromGlobal(block.x, block.y, block.z);
 }
 
 /**
@@ -120,15 +227,19 @@ void ChunkManager::setBlockGlobal(int x, int y, int z, int blockid)
 */
 Chunk* ChunkManager::getChunkFromGlobal(int x, int y, int z)
 {
-    // Get the chunk from global block position
-    int cx = x / chunkSize.x;
-    int cy = y / chunkSize.y;
-    int cz = z / chunkSize.z;
+    return access(chunks.get(toChunkPos(x, y, z)));
+}
 
-    if (ChunkOutOfBounds(cx, cy, cz))
-        return nullptr;
+/**
+ * Desc. Returns the amount of memory used by the block data and meshes of every chunk
+*/
+size_t ChunkManager::getMemoryUsage()
+{
+    size_t total = 0;
+    for (auto& chunk : chunks)
+        total += chunk->getMemoryUsage();
 
-    return chunks[IndexFrom3D(cx, cy, cz)].get();
+    return total;
 }
 
 /**
@@ -152,7 +263,7 @@ void ChunkManager::generateFlatTerrain(int minAmp)
                 for (int y = 0; y < (int)chunkSize.y; y++)
                 {
                     // Get the voxels global Y position
-                    int voxelY = chunk->chunk.position.y + y;
+                    int voxelY = chunk->getPosition().y + y;
 
                     if (voxelY == height)     chunk->setBlockLocal(x, y, z, Blocks::GRASS);
                     else if (voxelY < height) chunk->setBlockLocal(x, y, z, Blocks::DIRT);
@@ -161,7 +272,10 @@ void ChunkManager::generateFlatTerrain(int minAmp)
     };
 
     for (auto& chunk : chunks)
-        createTerrain(chunk.get());
+    {
+        createTerrain(chunk);
+        chunk->compact();
+    }
 
     /*
     *   Note
@@ -179,16 +293,112 @@ void ChunkManager::generateFlatTerrain(int minAmp)
         chunk->Update();
 }
 
+/**
+ * Desc. Sets up the simplex terrain used for every chunk that gets generated
+ *
+ * Note. The same seed always generates the same terrain
+*/
+void ChunkManager::setTerrain(int minAmp, int maxAmp, int seed)
+{
+    m_minAmp = minAmp;
+    m_maxAmp = maxAmp;
+    m_seed = seed;
+}
+
 /** 
  * Desc. Generates a terrain using simplex noise
 */
 void ChunkManager::generateTerrain(int minAmp, int maxAmp)
 {
-    auto createTree = [&](glm::vec3 location)
+    setTerrain(minAmp, maxAmp, Math::iRandom(0, 65536));
+
+    for (auto& chunk : chunks)
+    {
+        generateChunkTerrain(chunk);
+        chunk->compact();
+    }
+
+    // Check note in generateFlatTerrain() function
+    for (auto& chunk : chunks)
+        chunk->Update();
+}
+
+/**
+ * Desc. Returns the height of the terrain surface at the given global column
+*/
+int ChunkManager::getTerrainHeight(int x, int z)
+{
+    Noise::NoiseOptions firstNoise;
+    firstNoise.octaves = 6;
+    firstNoise.frequency = 0.25f;
+    firstNoise.roughness = 0.5f;
+    firstNoise.redistribution = 1.0f;
+
+    Noise::NoiseOptions secondNoise;
+    secondNoise.octaves = 4;
+    secondNoise.frequency = 0.1f;
+    secondNoise.roughness = 0.48f;
+    secondNoise.redistribution = 2.5f;
+
+    // Calculate the peaks
+    float posX = (float)x / chunkSize.x;
+    float posZ = (float)z / chunkSize.z;
+
+    // Combine 2 noise height maps for hilly and flat terrain combos
+    float noise1 = Noise::simplex2(posX + m_seed, posZ + m_seed, firstNoise);
+    float noise2 = Noise::simplex2(posX + m_seed, posZ + m_seed, secondNoise);
+    float result = noise1 * noise2;
+
+    return result * m_maxAmp + m_minAmp;
+}
+
+/**
+ * Desc. Returns a random value in [0, 1) that only depends on the seed and the column
+*/
+static float columnRandom(int seed, int x, int z, uint32_t salt)
+{
+    uint32_t h = (uint32_t)seed * 0x9E3779B1u;
+    h ^= (uint32_t)x * 0x85EBCA77u;
+    h ^= (uint32_t)z * 0xC2B2AE3Du;
+    h ^= salt * 0x27D4EB2Fu;
+
+    h ^= h >> 15;
+    h *= 0x2C1B3C6Du;
+    h ^= h >> 12;
+    h *= 0x297A2D39u;
+    h ^= h >> 15;
+
+    return (h & 0xFFFFFF) / 16777216.0f;
+}
+
+/**
+ * Desc. Fills a single chunk with simplex terrain and the trees that reach into it
+ *
+ * Note. A chunk only depends on the seed and its position so chunks can be
+ * generated in any order and regenerated later with the same result
+*/
+void ChunkManager::generateChunkTerrain(Chunk* chunk)
+{
+    const glm::ivec3 origin = glm::ivec3(chunk->getPosition());
+    const glm::ivec3 size = glm::ivec3(chunkSize);
+
+    // Tree blocks can reach up to 2 blocks out from the trunk so trees rooted in
+    // neighbouring columns have to be placed as well
+    const int treeReach = 2;
+
+    auto setBlock = [&](int x, int y, int z, int block)
+    {
+        x -= origin.x;
+        y -= origin.y;
+        z -= origin.z;
+        if (x >= 0 && x < size.x && y >= 0 && y < size.y && z >= 0 && z < size.z)
+            chunk->setBlockLocal(x, y, z, block);
+    };
+
+    auto createTree = [&](glm::ivec3 location, int treeHeight)
     {
-        int treeHeight = Math::iRandom(4, 7);
         for (int i = 0; i < treeHeight; i++)
-            setBlockGlobal(location.x, location.y + i, location.z, Blocks::LOG);
+            setBlock(location.x, location.y + i, location.z, Blocks::LOG);
 
         for (int x = -2; x <= 2; x++)
             for (int y = -2; y < 1; y++)
@@ -203,122 +413,733 @@ void ChunkManager::generateTerrain(int minAmp, int maxAmp)
                     if (y == 0 && (abs(x) >= 1 || abs(z) >= 1))
                         continue;
 
-                    setBlockGlobal(location.x + x, location.y + y + treeHeight, location.z + z, Blocks::LEAF);
+                    setBlock(location.x + x, location.y + y + treeHeight, location.z + z, Blocks::LEAF);
                 }
 
-        setBlockGlobal(location.x + 1, location.y + treeHeight, location.z + 0, Blocks::LEAF);
-        setBlockGlobal(location.x - 1, location.y + treeHeight, location.z + 0, Blocks::LEAF);
-        setBlockGlobal(location.x + 0, location.y + treeHeight, location.z + 1, Blocks::LEAF);
-        setBlockGlobal(location.x + 0, location.y + treeHeight, location.z - 1, Blocks::LEAF);
+        setBlock(location.x + 1, location.y + treeHeight, location.z + 0, Blocks::LEAF);
+        setBlock(location.x - 1, location.y + treeHeight, location.z + 0, Blocks::LEAF);
+        setBlock(location.x + 0, location.y + treeHeight, location.z + 1, Blocks::LEAF);
+        setBlock(location.x + 0, location.y + treeHeight, location.z - 1, Blocks::LEAF);
     };
 
-    int seed = Math::iRandom(0, 65536);
+    // The noise is only sampled once per column, the blocks are then filled
+    // in the order the chunk stores them
+    std::vector<int> heights(size.x * size.z);
+    for (int x = 0; x < size.x; x++)
+        for (int z = 0; z < size.z; z++)
+            heights[x * size.z + z] = getTerrainHeight(origin.x + x, origin.z + z);
 
-    Noise::NoiseOptions firstNoise;
-    firstNoise.octaves = 6;
-    firstNoise.frequency = 0.25f;
-    firstNoise.roughness = 0.5f;
-    firstNoise.redistribution = 1.0f;
+    chunk->fill([&](int x, int y, int z)
+    {
+        int height = heights[x * size.z + z];
 
-    Noise::NoiseOptions secondNoise;
-    secondNoise.octaves = 4;
-    secondNoise.frequency = 0.1f;
-    secondNoise.roughness = 0.48f;
-    secondNoise.redistribution = 2.5f;
+        // Get the voxels global Y position
+        int voxelY = origin.y + y;
 
-    auto createTerrain = [&](Chunk* chunk)
+        /*
+        *   First layer is grass
+        *   the next 3 layers are dirt
+        *   everything below that is stone
+        *   Water spawns above the peaks(height) if they are below the
+        *   given water_level threshold
+        */
+
+        // If we went over the peaks any blocks above them are AIR
+        // so if they are under the WATER_LEVEL we can place WATER BLOCK
+        // there instead of AIR blocks
+        if (voxelY > height)
+            return voxelY < WATER_LEVEL ? Blocks::WATER : Blocks::AIR;
+
+        // Set SAND to spawn next to WATER, otherwise set the top block
+        if (voxelY == height)
+            return voxelY < WATER_LEVEL ? Blocks::SAND : Blocks::GRASS;
+
+        if (voxelY > height - 4)
+            return Blocks::DIRT;
+
+        return Blocks::STONE;
+    });
+
+    // Generate trees on the top grass blocks randomly
+    for (int x = -treeReach; x < size.x + treeReach; x++)
+        for (int z = -treeReach; z < size.z + treeReach; z++)
+        {
+            int gx = origin.x + x;
+            int gz = origin.z + z;
+
+            if (columnRandom(m_seed, gx, gz, 0) < 0.99f)
+                continue;
+
+            int height = getTerrainHeight(gx, gz);
+            if (height < WATER_LEVEL)
+                continue;
+
+            // Skip trees that can't reach into this chunk
+            const int maxTreeHeight = 7;
+            if (height + maxTreeHeight < origin.y || height > origin.y + size.y)
+                continue;
+
+            int treeHeight = 4 + (int)(columnRandom(m_seed, gx, gz, 1) * 4);
+            createTree({ gx, height, gz }, treeHeight);
+        }
+}
+
+/**
+ * Desc. Sets how many chunks around the camera are kept loaded
+ *
+ * Note. Chunks are unloaded once they are unloadMargin chunks further away than
+ * the load radius so moving back and forth over a chunk border doesn't reload them
+*/
+void ChunkManager::setStreamingRadius(int horizontal, int vertical, int unloadMargin)
+{
+    m_loadRadius = horizontal;
+    m_loadHeight = vertical;
+    m_unloadMargin = unloadMargin;
+    m_streamingStarted = false;
+}
+
+void ChunkManager::setChunksPerFrame(int count)
+{
+    m_chunksPerFrame = count;
+}
+
+/**
+ * Desc. Streams chunks in and out around the given (camera) position, called once per frame
+*/
+void ChunkManager::Update(const glm::vec3& position)
+{
+    glm::ivec3 block = glm::floor(position);
+    ChunkPos centre = toChunkPos(block.x, block.y, block.z);
+
+    // Only rebuild the queue when we move into another chunk
+    if (!m_streamingStarted || centre != m_streamCentre)
     {
-        // Go through every block in the chunk
-        for (int x = 0; x < (int)chunkSize.x; x++)
-            for (int z = 0; z < (int)chunkSize.z; z++)
-            {
-                // Calculate the peaks
-                float posX = (chunk->chunk.position.x + x) / chunkSize.x;
-                float posZ = (chunk->chunk.position.z + z) / chunkSize.z;
+        m_streamCentre = centre;
+        m_streamingStarted = true;
 
-                // Combine 2 noise height maps for hilly and flat terrain combos
-                float noise1 = Noise::simplex2(posX + seed, posZ + seed, firstNoise);
-                float noise2 = Noise::simplex2(posX + seed, posZ + seed, secondNoise);
-                float result = noise1 * noise2;
+        scheduleUnloadRetry(unloadFarChunks(), false);
+        queueChunksInRange();
+        updateMeshes();
+    }
+    else if (m_unloadRetryFrame != 0 && m_frame >= m_unloadRetryFrame)
+    {
+        // Chunks that failed to save are still waiting to be unloaded, region files
+        // that couldn't be opened are opened again for it
+        for (auto it = m_regions.begin(); it != m_regions.end(); )
+            it = it->second->isOpen() ? std::next(it) : m_regions.erase(it);
 
-                int height = result * maxAmp + minAmp;
+        scheduleUnloadRetry(unloadFarChunks(), true);
+    }
 
-                // Check if the height is valid
-                if (height > (chunkSize.y * worldSize.y))
-                    height = (chunkSize.y * worldSize.y);
+    loadQueuedChunks();
+    evictChunks();
+    remeshDirty();
 
-                // For every y block in the chunk set its layers
-                for (int y = 0; y < (int)chunkSize.y; y++)
-                {
-                    // Get the voxels global Y position
-                    int voxelY = chunk->chunk.position.y + y;
-
-                    /*
-                    *   First layer is grass
-                    *   the next 3 layers are dirt
-                    *   everything below that is stone
-                    *   Water spawns above the peaks(height) if they are below the
-                    *   given water_level threshold
-                    */
-
-                    // If we went over the peaks any blocks above them are AIR
-                    // so if they are under the WATER_LEVEL we can place WATER BLOCK
-                    // there instead of AIR blocks
-                    if (voxelY > height)
-                    {
-                        if (voxelY < WATER_LEVEL)
-                            chunk->setBlockLocal(x, y, z, Blocks::WATER);
-                    }
-                    else if (voxelY == height)
-                    {
-                        // Set SAND to spawn next to WATER
-                        if (voxelY < WATER_LEVEL)
-                            chunk->setBlockLocal(x, y, z, Blocks::SAND);
-                        // Set the top block
-                        else
-                        {
-                            chunk->setBlockLocal(x, y, z, Blocks::GRASS);
-                            // Generate trees on the top block randomly
-                            if (Math::fRandom(0, 1) >= 0.99f)
-                                if (x > 0 && x + 1 < (int)chunkSize.x && z > 0 && z + 1 < (int)chunkSize.z)
-                                {
-                                    glm::vec3 location;
-                                    location.x = chunk->chunk.position.x + x;
-                                    location.y = (float)height;
-                                    location.z = chunk->chunk.position.z + z;
-                                    createTree(location);
-                                }
-                        }
-                    }
-                    else if (voxelY < height && voxelY > height - 4) chunk->setBlockLocal(x, y, z, Blocks::DIRT);
-                    else if (voxelY < height) chunk->setBlockLocal(x, y, z, Blocks::STONE);
-                }
+    // Everything touched from here on belongs to the next frame
+    m_frame++;
+}
+
+/**
+ * Desc. Queues every missing chunk in the load radius, nearest chunks get loaded first
+*/
+void ChunkManager::queueChunksInRange()
+{
+    m_loadQueue.clear();
+
+    for (int x = -m_loadRadius; x <= m_loadRadius; x++)
+        for (int y = -m_loadHeight; y <= m_loadHeight; y++)
+            for (int z = -m_loadRadius; z <= m_loadRadius; z++)
+            {
+                if (x * x + z * z > m_loadRadius * m_loadRadius)
+                    continue;
+
+                ChunkPos pos = m_streamCentre + ChunkPos(x, y, z);
+                if (chunks.get(pos) == nullptr)
+                    m_loadQueue.push_back(pos);
             }
+
+    // Sort furthest first so the nearest chunk can be popped off the back
+    auto distance = [&](const ChunkPos& pos)
+    {
+        ChunkPos d = pos - m_streamCentre;
+        return d.x * d.x + d.y * d.y + d.z * d.z;
     };
+    std::sort(m_loadQueue.begin(), m_loadQueue.end(), [&](const ChunkPos& a, const ChunkPos& b)
+    {
+        return distance(a) > distance(b);
+    });
+}
 
-    for (auto& chunk : chunks)
-        createTerrain(chunk.get());
+/**
+ * Desc. Loads, generates and meshes up to chunksPerFrame chunks from the load queue
+*/
+void ChunkManager::loadQueuedChunks()
+{
+    int loaded = 0;
 
-    // Check note in generateFlatTerrain() function
-    for (auto& chunk : chunks)
-        chunk->Update();
+    // Evicted chunks that are needed again come first, they are already in view
+    while (loaded < m_chunksPerFrame && !m_restoreQueue.empty())
+    {
+        Chunk* chunk = chunks.get(m_restoreQueue.back());
+        m_restoreQueue.pop_back();
+
+        if (chunk == nullptr || chunk->isResident())
+            continue;
+
+        restoreChunk(chunk);
+        loaded++;
+    }
+
+    while (loaded < m_chunksPerFrame && !m_loadQueue.empty())
+    {
+        ChunkPos pos = m_loadQueue.back();
+        m_loadQueue.pop_back();
+
+        if (chunks.get(pos) != nullptr)
+            continue;
+
+        // Saved chunks are read back, everything else is generated
+        Chunk* chunk = loadChunk(pos);
+        if (!loadChunkData(pos, chunk))
+        {
+            generateChunkTerrain(chunk);
+            chunk->compact();
+        }
+        chunk->touch(m_frame);
+        if (inRenderRange(pos))
+            chunk->setMesh(table.acquireMesh());
+        loaded++;
+
+        // The neighbours can now see the new chunks border blocks so they need a new mesh as well,
+        // the remesh pass meshes them once even if several of their neighbours got loaded
+        markDirty(chunk, Chunk::ALL_BORDERS);
+    }
 }
 
 /**
- * Desc. Converts a 3D coordinate into 1D
+ * Desc. Sets how many chunks around the camera get a mesh, chunks further away
+ * stay loaded without any GPU buffers
 */
-int ChunkManager::IndexFrom3D(int x, int y, int z)
+void ChunkManager::setRenderDistance(int horizontal, int vertical)
 {
-    // Index = ((x * YSIZE + y) * ZSIZE) + z;
-    return ((x * worldSize.y + y) * worldSize.z) + z;
+    m_renderRadius = horizontal;
+    m_renderHeight = vertical;
+    m_streamingStarted = false;
 }
 
-/** 
- * Desc. Check if a chunk is out of bound
+void ChunkManager::setMeshMode(ChunkMesher::Mode mode)
+{
+    if (mode == ChunkMesher::getMode())
+        return;
+
+    ChunkMesher::setMode(mode);
+    for (auto chunk : chunks)
+        if (chunk->getMesh() != nullptr && chunk->isResident())
+            markDirty(chunk);
+}
+
+bool ChunkManager::inRenderRange(const ChunkPos& pos)
+{
+    // Headless managers have nothing to render to
+    if (m_atlas == nullptr)
+        return false;
+
+    ChunkPos d = pos - m_streamCentre;
+    return d.x * d.x + d.z * d.z <= m_renderRadius * m_renderRadius && d.y <= m_renderHeight && d.y >= -m_renderHeight;
+}
+
+/**
+ * Desc. Gives the chunks that came into render range a mesh and takes it away
+ * from the ones that left it
+*/
+void ChunkManager::updateMeshes()
+{
+    for (auto it = chunks.begin(); it != chunks.end(); ++it)
+    {
+        Chunk* chunk = *it;
+        bool inRange = inRenderRange(it.pos());
+
+        if (inRange && chunk->getMesh() == nullptr)
+        {
+            chunk->setMesh(table.acquireMesh());
+            markDirty(chunk);
+        }
+        else if (!inRange && chunk->getMesh() != nullptr)
+            table.releaseMesh(chunk->takeMesh());
+    }
+}
+
+/**
+ * Desc. Unloads every chunk outside of the load radius plus the unload margin
+ *
+ * Note. A chunk that can't be saved stays loaded so its edits aren't lost and
+ * false is returned, see scheduleUnloadRetry(). Without a world directory there
+ * is nothing to save to and chunks are dropped
+*/
+bool ChunkManager::unloadFarChunks()
+{
+    const int radius = m_loadRadius + m_unloadMargin;
+    const int height = m_loadHeight + m_unloadMargin;
+
+    std::vector<ChunkPos> far;
+    for (auto it = chunks.begin(); it != chunks.end(); ++it)
+    {
+        ChunkPos d = it.pos() - m_streamCentre;
+        if (d.x * d.x + d.z * d.z > radius * radius || d.y > height || d.y < -height)
+            far.push_back(it.pos());
+    }
+
+    bool saved = true;
+    for (auto& pos : far)
+    {
+        if (!m_saveDirectory.empty() && !saveChunk(pos, chunks.get(pos)))
+        {
+            saved = false;
+            continue;
+        }
+
+        unloadChunk(pos);
+    }
+    return saved;
+}
+
+/**
+ * Desc. Plans when chunks that failed to save are unloaded again
+ *
+ * Note. The first failure waits UNLOAD_RETRY_MIN frames, every failed retry
+ * doubles the wait up to UNLOAD_RETRY_MAX. Failures while moving don't push
+ * a retry that is already planned further away
+*/
+void ChunkManager::scheduleUnloadRetry(bool saved, bool retry)
+{
+    if (saved)
+    {
+        m_unloadRetryFrame = 0;
+        m_unloadRetryDelay = UNLOAD_RETRY_MIN;
+        return;
+    }
+
+    if (retry)
+        m_unloadRetryDelay = std::min(m_unloadRetryDelay * 2, UNLOAD_RETRY_MAX);
+    else if (m_unloadRetryFrame != 0)
+        return;
+
+    m_unloadRetryFrame = m_frame + m_unloadRetryDelay;
+}
+
+/**
+ * Desc. Saves chunks into region files inside of the given directory
+ *
+ * Note. If the directory already has a world its seed is used, otherwise
+ * the current terrain settings are saved for it
+*/
+void ChunkManager::openWorld(const std::string& directory)
+{
+    m_saveDirectory = directory;
+    m_regions.clear();
+
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+
+    // Undo history that doesn't fit in memory goes next to the world
+    journal.setSpillFile(directory + "/journal.tmp");
+
+    const std::string worldFile = directory + "/world.dat";
+    std::ifstream in(worldFile);
+    if (in.is_open())
+    {
+        int seed, minAmp, maxAmp;
+        if (in >> seed >> minAmp >> maxAmp)
+        {
+            setTerrain(minAmp, maxAmp, seed);
+            printf("Loaded world %s with seed %d\n", directory.c_str(), seed);
+            return;
+        }
+    }
+
+    std::ofstream out(worldFile);
+    out << m_seed << " " << m_minAmp << " " << m_maxAmp << "\n";
+    printf("Created world %s with seed %d\n", directory.c_str(), m_seed);
+}
+
+/**
+ * Desc. Writes the chunk into its region file
 */
-bool ChunkManager::ChunkOutOfBounds(int x, int y, int z)
+bool ChunkManager::saveChunk(const ChunkPos& pos, Chunk* chunk)
 {
-    if (x < 0 || x >= worldSize.x || y < 0 || y >= worldSize.y || z < 0 || z >= worldSize.z)
+    if (chunk == nullptr)
+        return false;
+
+    // Evicted chunks were saved before they got evicted
+    if (!chunk->isResident())
         return true;
-    else return false;
-}
\ No newline at end of file
+
+    RegionFile* region = getRegion(pos, true);
+    if (region == nullptr)
+        return false;
+
+    // Serialize into the reused staging buffer so saving doesn't allocate
+    m_staging.clear();
+    if (m_saveMode == SaveMode::DELTA)
+    {
+        // An unmodified chunk is exactly what the generator makes, nothing to save
+        if (!chunk->isModified())
+            return true;
+
+        m_staging.push_back(SAVE_DELTA);
+        chunk->serializeEdits(m_staging);
+    }
+    else
+    {
+        m_staging.push_back(chunk->getLayout().getType() == ChunkLayout::MORTON ? SAVE_FULL_MORTON : SAVE_FULL);
+        chunk->serialize(m_staging);
+    }
+
+    return region->write(pos, m_staging);
+}
+
+void ChunkManager::setSaveMode(SaveMode mode)
+{
+    m_saveMode = mode;
+}
+
+/**
+ * Desc. Reads the chunks blocks from its region file
+ *
+ * Note. Returns false if the chunk was never saved
+*/
+bool ChunkManager::loadChunkData(const ChunkPos& pos, Chunk* chunk)
+{
+    RegionFile* region = getRegion(pos, false);
+    if (region == nullptr)
+        return false;
+
+    size_t size = 0;
+    const uint8_t* data = region->read(pos, size);
+    if (data == nullptr || size == 0)
+        return false;
+
+    if (data[0] == SAVE_DELTA)
+    {
+        // Regenerate the chunk and apply the players edits on top
+        generateChunkTerrain(chunk);
+        bool loaded = chunk->deserializeEdits(data + 1, size - 1);
+        chunk->compact();
+        return loaded;
+    }
+
+    if (data[0] == SAVE_FULL)
+        return chunk->deserialize(data + 1, size - 1, ChunkLayout::LINEAR);
+    if (data[0] == SAVE_FULL_MORTON)
+        return chunk->deserialize(data + 1, size - 1, ChunkLayout::MORTON);
+
+    return false;
+}
+
+/**
+ * Desc. Saves every loaded chunk
+*/
+void ChunkManager::saveAll()
+{
+    if (m_saveDirectory.empty())
+        return;
+
+    for (auto it = chunks.begin(); it != chunks.end(); ++it)
+        saveChunk(it.pos(), *it);
+}
+
+void ChunkManager::setMemoryBudget(size_t bytes)
+{
+    m_memoryBudget = bytes;
+}
+
+/**
+ * Desc. Marks the chunk as used this frame, an evicted chunk is queued to be
+ * restored by the next Update()
+*/
+void ChunkManager::touch(Chunk* chunk)
+{
+    chunk->touch(m_frame);
+    if (chunk->isResident())
+        return;
+
+    ChunkPos pos = getChunkPos(chunk);
+    if (std::find(m_restoreQueue.begin(), m_restoreQueue.end(), pos) == m_restoreQueue.end())
+        m_restoreQueue.push_back(pos);
+}
+
+ChunkPos ChunkManager::getChunkPos(Chunk* chunk)
+{
+    glm::ivec3 block = glm::floor(chunk->getPosition());
+    return toChunkPos(block.x, block.y, block.z);
+}
+
+/**
+ * Desc. Marks the chunk as used and restores it right away if it was evicted
+ *
+ * Note. Used by the block accessors since they need the real blocks immediately
+*/
+Chunk* ChunkManager::access(Chunk* chunk)
+{
+    if (chunk == nullptr)
+        return nullptr;
+
+    chunk->touch(m_frame);
+    if (!chunk->isResident())
+        restoreChunk(chunk);
+
+    return chunk;
+}
+
+/**
+ * Desc. Fills an evicted chunk again from its save or from the seed and meshes it
+*/
+void ChunkManager::restoreChunk(Chunk* chunk)
+{
+    ChunkPos pos = getChunkPos(chunk);
+    if (!loadChunkData(pos, chunk))
+    {
+        generateChunkTerrain(chunk);
+        chunk->compact();
+    }
+    chunk->setResident();
+
+    // Neighbours meshed while we were evicted have faces against our border
+    markDirty(chunk, Chunk::ALL_BORDERS);
+}
+
+/**
+ * Desc. Queues the chunk and the resident neighbours on the given borders
+ * for the remesh pass at the end of Update()
+ *
+ * Note. A chunk is only queued once however often it's marked
+*/
+void ChunkManager::markDirty(Chunk* chunk, uint8_t borders)
+{
+    if (chunk->markDirty())
+        m_remeshQueue.push_back(chunk->getHandle());
+
+    for (int i = 0; i < 6; i++)
+    {
+        if (!(borders & (1 << i)))
+            continue;
+
+        Chunk* neighbour = chunk->getNeighbour((NEIGHBOUR)i);
+        if (neighbour != nullptr && neighbour->isResident() && neighbour->markDirty())
+            m_remeshQueue.push_back(neighbour->getHandle());
+    }
+}
+
+/**
+ * Desc. Queues the sections of the chunk and of its resident neighbours that
+ * have faces against a block in the local box [min, max)
+ *
+ * Note. Section meshes look one row past their ends, so the rows right above
+ * and below the box are included
+*/
+void ChunkManager::markDirty(Chunk* chunk, const glm::ivec3& min, const glm::ivec3& max)
+{
+    if (chunk->markDirty(chunk->getSections(min.y - 1, max.y + 1)))
+        m_remeshQueue.push_back(chunk->getHandle());
+
+    const uint8_t borders = chunk->getBorders(min, max);
+    for (int i = 0; i < 6; i++)
+    {
+        if (!(borders & (1 << i)))
+            continue;
+
+        Chunk* neighbour = chunk->getNeighbour((NEIGHBOUR)i);
+        if (neighbour == nullptr || !neighbour->isResident())
+            continue;
+
+        // The chunk above only sees the box with its bottom row, the one below with its top row
+        uint32_t sections = neighbour->getSections(min.y, max.y);
+        if (i == ABOVE)
+            sections = 1;
+        else if (i == BELOW)
+            sections = 1u << (neighbour->getSectionCount() - 1);
+
+        if (neighbour->markDirty(sections))
+            m_remeshQueue.push_back(neighbour->getHandle());
+    }
+}
+
+bool ChunkManager::undo()
+{
+    if (!journal.popUndo(m_journalGroup))
+        return false;
+
+    applyJournal(m_journalGroup, true);
+    journal.pushRedo(m_journalGroup);
+    return true;
+}
+
+bool ChunkManager::redo()
+{
+    if (!journal.popRedo(m_journalGroup))
+        return false;
+
+    applyJournal(m_journalGroup, false);
+    journal.pushUndo(m_journalGroup);
+    return true;
+}
+
+/**
+ * Desc. Sets every block of the group back to its old block (undo) or to
+ * its new one (redo) and marks the chunks dirty like an EditBatch does
+ *
+ * Note. Evicted chunks are restored first, changes to chunks that were
+ * unloaded meanwhile are skipped. Undo walks the changes backwards so a block
+ * changed several times in the group ends up at its first before block
+*/
+void ChunkManager::applyJournal(const std::vector<uint8_t>& group, bool undo)
+{
+    Chunk*     chunk = nullptr;
+    ChunkPos   chunkPos;
+    glm::ivec3 min, max;
+
+    // Changes of a chunk are marked with the box around all of them
+    auto flush = [&]()
+    {
+        if (chunk != nullptr && min.x < max.x)
+            markDirty(chunk, min, max);
+    };
+
+    auto apply = [&](const ChunkPos& pos, const EditJournal::Change& change)
+    {
+        if (chunk == nullptr || pos != chunkPos)
+        {
+            flush();
+
+            chunk = getChunk(pos);
+            chunkPos = pos;
+            min = glm::ivec3(INT_MAX);
+            max = glm::ivec3(INT_MIN);
+        }
+        if (chunk == nullptr)
+            return;
+
+        const glm::ivec3 local(change.x, change.y, change.z);
+        const int block = undo ? change.before : change.after;
+        if (chunk->editBox(local, local + 1, [&](int, int, int, int) { return block; }) > 0)
+        {
+            min = glm::min(min, local);
+            max = glm::max(max, local + 1);
+        }
+    };
+
+    if (undo)
+        EditJournal::forEachChangeReverse(group, apply);
+    else
+        EditJournal::forEachChange(group, apply);
+
+    flush();
+}
+
+/**
+ * Desc. Remeshes every chunk that was marked dirty since the last pass
+ *
+ * Note. Chunks unloaded since they were queued have a stale handle and are skipped,
+ * chunks that got meshed meanwhile aren't dirty anymore
+*/
+void ChunkManager::remeshDirty()
+{
+#ifdef DEBUG
+    auto remeshStart = std::chrono::steady_clock::now();
+    int remeshed = 0;
+#endif
+
+    for (auto& handle : m_remeshQueue)
+    {
+        Chunk* chunk = table.get(handle);
+        if (chunk == nullptr || !chunk->isDirty())
+            continue;
+
+        chunk->Update();
+    #ifdef DEBUG
+        remeshed++;
+    #endif
+    }
+
+#ifdef DEBUG
+    if (!m_remeshQueue.empty())
+        printf("Remeshed %d dirty chunks in %.3f ms\n", remeshed,
+            std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - remeshStart).count());
+#endif
+
+    m_remeshQueue.clear();
+}
+
+/**
+ * Desc. Evicts the least recently used chunks until the chunks fit the memory budget
+ *
+ * Note. Unmodified chunks are simply dropped since the generator recreates them,
+ * modified chunks are saved first and are kept if they can't be saved.
+ * Chunks touched this frame are never evicted
+*/
+void ChunkManager::evictChunks()
+{
+    if (m_memoryBudget == 0)
+        return;
+
+    size_t usage = getMemoryUsage();
+    if (usage <= m_memoryBudget)
+        return;
+
+    std::vector<std::pair<uint32_t, ChunkPos>> candidates;
+    for (auto it = chunks.begin(); it != chunks.end(); ++it)
+    {
+        Chunk* chunk = *it;
+        if (chunk->isResident() && chunk->getLastAccess() < m_frame)
+            candidates.push_back({ chunk->getLastAccess(), it.pos() });
+    }
+
+    std::sort(candidates.begin(), candidates.end(), [](const auto& a, const auto& b)
+    {
+        return a.first < b.first;
+    });
+
+    int evicted = 0;
+    for (auto& candidate : candidates)
+    {
+        if (usage <= m_memoryBudget)
+            break;
+
+        Chunk* chunk = chunks.get(candidate.second);
+        if (chunk->isModified() && !saveChunk(candidate.second, chunk))
+            continue;
+
+        size_t before = chunk->getMemoryUsage();
+        chunk->evict();
+        usage -= before - chunk->getMemoryUsage();
+        evicted++;
+    }
+
+#ifdef DEBUG
+    if (evicted > 0)
+        printf("Evicted %d chunks, chunk memory %zu KB\n", evicted, usage / 1024);
+#endif
+}
+
+RegionFile* ChunkManager::getRegion(const ChunkPos& pos, bool create)
+{
+    if (m_saveDirectory.empty())
+        return nullptr;
+
+    const std::string path = m_saveDirectory + "/" + RegionFile::fileName(pos);
+
+    auto it = m_regions.find(path);
+    if (it != m_regions.end())
+        return it->second->isOpen() ? it->second.get() : nullptr;
+
+    // Don't create empty region files just because we looked for a chunk
+    if (!create && !std::filesystem::exists(path))
+        return nullptr;
+
+    // A region that failed to open is kept so it isn't opened (and reported) for every
+    // chunk and every frame, Update() drops it when the failed saves are tried again
+    auto region = std::make_unique<RegionFile>(path, chunkSize);
+    RegionFile* result = region->isOpen() ? region.get() : nullptr;
+    m_regions[path] = std::move(region);
+    return result;
+}
@@ -1,33 +1,165 @@
 #pragma once
 #include "../gl/glObjects.h"
 #include "chunk.h"
+#include "chunkmap.h"
+#include "chunktable.h"
+#include "editjournal.h"
+#include "regionfile.h"
+
+#include <memory>
+#include <string>
+#include <unordered_map>
 
 #define WATER_LEVEL 34
 
+/*
+    Save modes
+    ----------
+    FULL  - every chunk is saved with all of its blocks
+    DELTA - only blocks changed through setBlockGlobal are saved, on load the chunk
+            is generated again from the seed and the changes are applied on top
+*/
+enum class SaveMode
+{
+    FULL,
+    DELTA
+};
+
+/*
+    Chunk manager
+    -------------
+    Loads, generates, streams and saves the chunks of the world. Only meshing needs
+    the texture atlas, without one the manager runs headless: no chunk gets a mesh and
+    nothing touches GL, so the world can be generated, edited and saved without a
+    window (tests, benchmarks, servers).
+*/
 class ChunkManager
 {
 public:
-    ChunkManager();
+    // The atlas has to outlive the manager, nullptr = headless
+    ChunkManager(gl::TextureAtlas* atlas = nullptr);
+    ~ChunkManager();
 
     void generateChunks(int x, int y, int z);
 
     void setChunkSize(int x, int y, int z);
 
+    Chunk* loadChunk(const ChunkPos& pos);
+    void   unloadChunk(const ChunkPos& pos);
+    Chunk* getChunk(const ChunkPos& pos);
+
+    ChunkPos   toChunkPos(int x, int y, int z);
+    glm::ivec3 toLocalPos(int x, int y, int z);
+
     int  getBlockGlobal(int x, int y, int z);
     void setBlockGlobal(int x, int y, int z, int blockid);
 
     Chunk* getChunkFromGlobal(int x, int y, int z);
 
+    // World positions are floored first so negative positions land in the right block
+    int    getBlockGlobal(const glm::vec3& position);
+    void   setBlockGlobal(const glm::vec3& position, int blockid);
+    Chunk* getChunkFromGlobal(const glm::vec3& position);
+
+    size_t getMemoryUsage();
+
     void generateFlatTerrain(int minAmp);
     void generateTerrain(int minAmp, int maxAmp);
 
-    gl::TextureAtlas        atlas;
+    void setTerrain(int minAmp, int maxAmp, int seed);
+    int  getTerrainHeight(int x, int z);
+    void generateChunkTerrain(Chunk* chunk);
+
+    void setStreamingRadius(int horizontal, int vertical, int unloadMargin = 2);
+    void setRenderDistance(int horizontal, int vertical);
+    void setChunksPerFrame(int count);
+    // Chunks that have a mesh are remeshed with the new mode by the next Update()
+    void setMeshMode(ChunkMesher::Mode mode);
+    void Update(const glm::vec3& position);
+
+    // Unmodified chunks are evicted (least recently used first) once the chunks use
+    // more than bytes of memory and generated again when they are touched, 0 = no limit
+    void setMemoryBudget(size_t bytes);
+    void touch(Chunk* chunk);
+
+    // Queues the chunk and its resident neighbours on the given borders (bits of NEIGHBOUR)
+    // for a remesh, Update() remeshes every queued chunk once
+    void markDirty(Chunk* chunk, uint8_t borders = 0);
+    // Only queues the sections that can see a change of the blocks in the local box [min, max),
+    // in the chunk and in the neighbours whose border the box touches
+    void markDirty(Chunk* chunk, const glm::ivec3& min, const glm::ivec3& max);
+
+    // Undoes or redoes the newest group of the journal, returns false if there was nothing to undo or redo
+    bool undo();
+    bool redo();
 
-    std::vector<ChunkRef>   chunks;
+    void openWorld(const std::string& directory);
+    void setSaveMode(SaveMode mode);
+    bool saveChunk(const ChunkPos& pos, Chunk* chunk);
+    bool loadChunkData(const ChunkPos& pos, Chunk* chunk);
+    void saveAll();
+
+    ChunkTable              table;
+    ChunkMap                chunks;
+    EditJournal             journal;
     glm::vec3               worldSize;
     glm::uvec3              chunkSize;
 
 private:
-    int IndexFrom3D(int x, int y, int z);
-    bool ChunkOutOfBounds(int x, int y, int z);
+    gl::TextureAtlas*       m_atlas;
+
+    int                     m_seed;
+    int                     m_minAmp;
+    int                     m_maxAmp;
+
+    int                     m_loadRadius;
+    int                     m_loadHeight;
+    int                     m_unloadMargin;
+    int                     m_chunksPerFrame;
+    int                     m_renderRadius;
+    int                     m_renderHeight;
+
+    bool                    m_streamingStarted;
+    // Frame of the next try to unload the chunks that failed to save, 0 if none are waiting.
+    // The wait doubles with every failed try so a save that keeps failing isn't tried every frame
+    uint32_t                m_unloadRetryFrame;
+    uint32_t                m_unloadRetryDelay;
+    ChunkPos                m_streamCentre;
+    std::vector<ChunkPos>   m_loadQueue;
+
+    size_t                  m_memoryBudget;
+    uint32_t                m_frame;
+    std::vector<ChunkPos>   m_restoreQueue;
+    std::vector<ChunkHandle> m_remeshQueue;
+    std::vector<uint8_t>    m_journalGroup;
+
+    // First byte of every saved chunk, full saves also say which block layout they use
+    static constexpr uint8_t SAVE_FULL = 0;
+    static constexpr uint8_t SAVE_DELTA = 1;
+    static constexpr uint8_t SAVE_FULL_MORTON = 2;
+
+    // Frames to wait before unloading chunks that failed to save again, the first and the longest wait
+    static constexpr uint32_t UNLOAD_RETRY_MIN = 30;
+    static constexpr uint32_t UNLOAD_RETRY_MAX = 3600;
+
+    SaveMode                m_saveMode;
+    std::string             m_saveDirectory;
+    std::vector<uint8_t>    m_staging;
+    std::unordered_map<std::string, std::unique_ptr<RegionFile>> m_regions;
+
+    RegionFile* getRegion(const ChunkPos& pos, bool create);
+
+    void queueChunksInRange();
+    void loadQueuedChunks();
+    bool unloadFarChunks();
+    void scheduleUnloadRetry(bool saved, bool retry);
+    bool inRenderRange(const ChunkPos& pos);
+    void updateMeshes();
+
+    ChunkPos getChunkPos(Chunk* chunk);
+    Chunk*   access(Chunk* chunk);
+    void     restoreChunk(Chunk* chunk);
+    void     evictChunks();
+    void     remeshDirty();
+    void     applyJournal(const std::vector<uint8_t>& group, bool undo);
 };
\ No newline at end of file
@@ -0,0 +1,145 @@
+#include "chunkmap.h"
+
+ChunkMap::ChunkMap()
+    : m_count(0)
+{
+    rehash(64);
+}
+
+/**
+ * Desc. Returns the chunk at the given chunk coordinate
+ *
+ * Note. Returns nullptr if the chunk isn't loaded
+*/
+Chunk* ChunkMap::get(const ChunkPos& pos) const
+{
+    size_t i = hash(pos) & m_mask;
+    while (m_slots[i].chunk != nullptr)
+    {
+        if (m_slots[i].pos == pos)
+            return m_slots[i].chunk;
+
+        i = (i + 1) & m_mask;
+    }
+
+    return nullptr;
+}
+
+/**
+ * Desc. Adds a chunk to the map
+ *
+ * Note. Returns false and changes nothing if a chunk already exists at pos
+*/
+bool ChunkMap::insert(const ChunkPos& pos, Chunk* chunk)
+{
+    if ((m_count + 1) * 2 > m_slots.size())
+        rehash(m_slots.size() * 2);
+
+    size_t i = findSlot(pos);
+    if (m_slots[i].chunk != nullptr)
+        return false;
+
+    m_slots[i].pos = pos;
+    m_slots[i].chunk = chunk;
+    m_count++;
+    return true;
+}
+
+/**
+ * Desc. Removes the chunk at pos from the map and returns it
+ *
+ * Note. Returns nullptr if there was no chunk at pos
+*/
+Chunk* ChunkMap::erase(const ChunkPos& pos)
+{
+    size_t i = findSlot(pos);
+    if (m_slots[i].chunk == nullptr)
+        return nullptr;
+
+    Chunk* removed = m_slots[i].chunk;
+    m_slots[i].chunk = nullptr;
+    m_count--;
+
+    // Backward shift deletion
+    // - move every following entry of the probe run back into the hole
+    //   unless the entry is already sitting between its home slot and the hole
+    size_t hole = i;
+    size_t j = (i + 1) & m_mask;
+    while (m_slots[j].chunk != nullptr)
+    {
+        size_t home = hash(m_slots[j].pos) & m_mask;
+        if (((j - home) & m_mask) >= ((j - hole) & m_mask))
+        {
+            m_slots[hole] = m_slots[j];
+            m_slots[j].chunk = nullptr;
+            hole = j;
+        }
+        j = (j + 1) & m_mask;
+    }
+
+    return removed;
+}
+
+void ChunkMap::clear()
+{
+    for (auto& slot : m_slots)
+        slot.chunk = nullptr;
+
+    m_count = 0;
+}
+
+size_t ChunkMap::size() const
+{
+    return m_count;
+}
+
+bool ChunkMap::empty() const
+{
+    return m_count == 0;
+}
+
+ChunkMap::iterator ChunkMap::begin()
+{
+    return iterator(m_slots.data(), m_slots.data() + m_slots.size());
+}
+
+ChunkMap::iterator ChunkMap::end()
+{
+    return iterator(m_slots.data() + m_slots.size(), m_slots.data() + m_slots.size());
+}
+
+size_t ChunkMap::hash(const ChunkPos& pos) const
+{
+    // Multiply each axis by a large odd constant and fold the high bits down
+    // so neighbouring chunks don't end up in neighbouring slots
+    uint64_t h = (uint64_t)pos.x * 0x9E3779B97F4A7C15ull;
+    h ^= (uint64_t)pos.y * 0xC2B2AE3D27D4EB4Full;
+    h ^= (uint64_t)pos.z * 0x165667B19E3779F9ull;
+    h ^= h >> 29;
+    return (size_t)h;
+}
+
+/**
+ * Desc. Returns the slot holding pos or the empty slot where it would be inserted
+*/
+size_t ChunkMap::findSlot(const ChunkPos& pos) const
+{
+    size_t i = hash(pos) & m_mask;
+    while (m_slots[i].chunk != nullptr && m_slots[i].pos != pos)
+        i = (i + 1) & m_mask;
+
+    return i;
+}
+
+void ChunkMap::rehash(size_t capacity)
+{
+    std::vector<Slot> old;
+    old.swap(m_slots);
+
+    m_slots.resize(capacity);
+    m_mask = capacity - 1;
+
+    for (auto& slot : old)
+        if (slot.chunk != nullptr)
+            m_slots[findSlot(slot.pos)] = slot;
+}
@@ -0,0 +1,75 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtc/type_precision.hpp>
+#include "chunk.h"
+
+// Chunk coordinates, a chunk at (1, 0, 2) starts at block (1, 0, 2) * chunkSize
+typedef glm::i64vec3 ChunkPos;
+
+/*
+    Open addressing hash map from chunk coordinates to chunks
+    ---------------------------------------------------------
+    - Linear probing over a power of two table so a lookup is one hash,
+      one mask and usually a single slot compare
+    - The table is kept at most half full
+    - Erasing shifts the following entries back instead of leaving tombstones
+      so lookups never get slower as chunks are loaded and unloaded
+*/
+class ChunkMap
+{
+public:
+    struct Slot
+    {
+        ChunkPos pos;
+        Chunk*   chunk; // nullptr if the slot is empty, the chunks are owned by the ChunkTable
+    };
+
+    class iterator
+    {
+    public:
+        iterator(Slot* slot, Slot* end)
+            : m_slot(slot), m_end(end)
+        {
+            skipEmpty();
+        }
+
+        Chunk*& operator*() const { return m_slot->chunk; }
+        Chunk*  operator->() const { return m_slot->chunk; }
+        const ChunkPos& pos() const { return m_slot->pos; }
+
+        iterator& operator++() { m_slot++; skipEmpty(); return *this; }
+        bool operator!=(const iterator& other) const { return m_slot != other.m_slot; }
+        bool operator==(const iterator& other) const { return m_slot == other.m_slot; }
+
+    private:
+        void skipEmpty() { while (m_slot != m_end && m_slot->chunk == nullptr) m_slot++; }
+
+        Slot* m_slot;
+        Slot* m_end;
+    };
+
+public:
+    ChunkMap();
+
+    Chunk*   get(const ChunkPos& pos) const;
+    bool     insert(const ChunkPos& pos, Chunk* chunk);
+    Chunk*   erase(const ChunkPos& pos);
+    void     clear();
+
+    size_t size() const;
+    bool   empty() const;
+
+    iterator begin();
+    iterator end();
+
+private:
+    std::vector<Slot> m_slots;
+    size_t            m_count;
+    size_t            m_mask;
+
+    size_t hash(const ChunkPos& pos) const;
+    size_t findSlot(const ChunkPos& pos) const;
+    void   rehash(size_t capacity);
+};
@@ -0,0 +1,183 @@
+#include "chunkmesh.h"
+
+// Room every section gets on top of its quads when the ranges are laid out
+static size_t getSlack(size_t quads)
+{
+    return quads / 4 + 16;
+}
+
+static const GLsizeiptr QUAD_BYTES = 4 * sizeof(GLuint);
+
+ChunkMesh::ChunkMesh(gl::TextureAtlas* atlas)
+    : entity(false)
+    , m_version(0)
+    , m_quads(0)
+    , m_capacity(0)
+{
+    entity.texture.texture = atlas->texture.texture;
+}
+
+void ChunkMesh::reset(glm::vec3 position)
+{
+    entity.position = position;
+
+    // Keep the VBO, the next mesh is uploaded into it
+    m_sections.clear();
+    m_ranges.clear();
+    m_version = 0;
+    m_quads = 0;
+}
+
+/**
+ * Desc. Uploads the sections built from the given version of the chunks blocks
+ *
+ * Note. The other sections keep what they had, if this is the first upload since the
+ * last reset every section has to be given (see getMissingSections())
+*/
+void ChunkMesh::upload(const std::vector<MeshData>& meshes, uint32_t sections, uint32_t version)
+{
+    if (m_sections.size() != meshes.size())
+        m_sections.assign(meshes.size(), Section());
+
+    bool fits = !entity.VBOs.empty();
+    for (size_t i = 0; i < meshes.size() && fits; i++)
+        if ((sections >> i) & 1)
+            fits = meshes[i].getQuadCount() <= m_sections[i].capacity;
+    if (!fits)
+        relayout(meshes, sections);
+
+    gl::VertexBufferObject& vbo = *entity.VBOs[0];
+    for (size_t i = 0; i < meshes.size(); i++)
+    {
+        if (((sections >> i) & 1) == 0)
+            continue;
+
+        Section& section = m_sections[i];
+        if (!meshes[i].verticies.empty())
+            vbo.setSubData(section.first * QUAD_BYTES, meshes[i].verticies);
+        section.quads = meshes[i].getQuadCount();
+        section.uploaded = true;
+    }
+
+    // Neighbouring sections are drawn as one range when nothing is between them
+    m_ranges.clear();
+    m_quads = 0;
+    for (const Section& section : m_sections)
+    {
+        if (section.quads == 0)
+            continue;
+
+        if (!m_ranges.empty() && m_ranges.back().first + m_ranges.back().count == section.first)
+            m_ranges.back().count += section.quads;
+        else
+            m_ranges.push_back({ section.first, section.quads });
+        m_quads += section.quads;
+    }
+    m_version = version;
+}
+
+/**
+ * Desc. Lays the sections out again, with room for the new meshes of the given sections
+ *
+ * Note. The buffer is reused when no section has to be kept and it's big enough,
+ * otherwise a new one is created and the kept sections are copied over to it
+*/
+void ChunkMesh::relayout(const std::vector<MeshData>& meshes, uint32_t sections)
+{
+    std::vector<Section> layout(m_sections.size());
+    size_t capacity = 0;
+    bool keep = false;
+    for (size_t i = 0; i < layout.size(); i++)
+    {
+        const bool changed = (sections >> i) & 1;
+        const size_t quads = changed ? meshes[i].getQuadCount() : m_sections[i].quads;
+
+        layout[i].first = capacity;
+        layout[i].capacity = quads + getSlack(quads);
+        layout[i].quads = changed ? 0 : m_sections[i].quads;
+        layout[i].uploaded = !changed && m_sections[i].uploaded;
+        capacity += layout[i].capacity;
+        keep |= layout[i].quads != 0;
+    }
+
+    if (!entity.VBOs.empty() && !keep && capacity <= m_capacity)
+    {
+        m_sections = std::move(layout);
+        return;
+    }
+
+    auto vbo = std::make_unique<gl::VertexBufferObject>();
+    vbo->allocate(capacity * QUAD_BYTES, GL_DYNAMIC_DRAW);
+    if (keep)
+    {
+        for (size_t i = 0; i < layout.size(); i++)
+            if (layout[i].quads != 0)
+                vbo->copySubData(*entity.VBOs[0], m_sections[i].first * QUAD_BYTES, layout[i].first * QUAD_BYTES, layout[i].quads * QUAD_BYTES);
+    }
+
+    entity.VAO.Bind();
+    vbo->defineIntegerAttribPointer(0, 1);
+    entity.VAO.Unbind();
+
+    // There are no indicies, every mesh is drawn with the shared quad index buffer
+    if (entity.VBOs.empty())
+    {
+        entity.VBOs.push_back(std::move(vbo));
+        Renderer::BindQuadIndices(entity.VAO);
+    }
+    else
+        entity.VBOs[0] = std::move(vbo);
+
+    m_sections = std::move(layout);
+    m_capacity = capacity;
+}
+
+/**
+ * Desc. Frees the vertex data, the mesh draws nothing until the next upload
+*/
+void ChunkMesh::clear()
+{
+    entity.VBOs.clear();
+    m_sections.clear();
+    m_ranges.clear();
+    m_quads = 0;
+    m_capacity = 0;
+}
+
+uint32_t ChunkMesh::getMissingSections(int count) const
+{
+    if (m_sections.size() != (size_t)count)
+        return count >= 32 ? 0xFFFFFFFF : (1u << count) - 1;
+
+    uint32_t missing = 0;
+    for (int i = 0; i < count; i++)
+        if (!m_sections[i].uploaded)
+            missing |= 1u << i;
+    return missing;
+}
+
+bool ChunkMesh::empty() const
+{
+    return m_quads == 0;
+}
+
+size_t ChunkMesh::getQuadCount() const
+{
+    return m_quads;
+}
+
+const std::vector<Renderer::QuadRange>& ChunkMesh::getRanges() const
+{
+    return m_ranges;
+}
+
+uint32_t ChunkMesh::getVersion() const
+{
+    return m_version;
+}
+
+size_t ChunkMesh::getMemoryUsage() const
+{
+    return sizeof(ChunkMesh) + m_sections.capacity() * sizeof(Section) + m_ranges.capacity() * sizeof(Renderer::QuadRange)
+         + m_capacity * QUAD_BYTES;
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+#include "../gl/glObjects.h"
+#include "../renderer/renderer.h"
+#include "../util/entity.h"
+#include "chunkmesher.h"
+
+/*
+    Chunk mesh
+    ----------
+    The GPU side of a chunk, only chunks inside of the render distance have one.
+    Creating one needs a GL context, Chunk itself never touches GL so chunks can be
+    generated, edited and saved without one.
+
+    Every section of the chunk (see Chunk::SECTION_HEIGHT) has its own range of the VBO
+    with some room to grow, so a remeshed section is written over its old verticies.
+    Only when it outgrows its range are the ranges laid out again, the sections that
+    didn't change are then copied into the new buffer on the GPU.
+*/
+class ChunkMesh
+{
+public:
+    ChunkMesh(gl::TextureAtlas* atlas);
+
+    // Moves the mesh to the chunk at position and drops the old sections, the VBO is kept
+    void reset(glm::vec3 position);
+
+    // Uploads meshes[i] for every bit i of sections, meshes has one entry per section of the chunk
+    void upload(const std::vector<MeshData>& meshes, uint32_t sections, uint32_t version);
+    void clear();
+
+    // Sections that were never uploaded, for a chunk with count sections
+    uint32_t getMissingSections(int count) const;
+
+    bool     empty() const;
+    uint32_t getVersion() const;
+    size_t   getQuadCount() const;
+    size_t   getMemoryUsage() const;
+
+    // Draw with Renderer::RenderQuads() and getRanges(), the entity has no EBO of its own
+    const std::vector<Renderer::QuadRange>& getRanges() const;
+    Entity entity;
+
+private:
+    // In quads, like the ranges
+    struct Section
+    {
+        size_t first    = 0;
+        size_t capacity = 0;
+        size_t quads    = 0;
+        bool   uploaded = false;
+    };
+
+    std::vector<Section>             m_sections;
+    std::vector<Renderer::QuadRange> m_ranges;
+    uint32_t m_version;
+    size_t   m_quads;
+    size_t   m_capacity;
+
+    void relayout(const std::vector<MeshData>& meshes, uint32_t sections);
+};
@@ -0,0 +1,302 @@
+#include "chunkmesher.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include "../util/cube.h"
+#include "blocks.h"
+#include "chunkkernels.h"
+
+namespace
+{
+    std::atomic<ChunkMesher::Mode> meshMode(ChunkMesher::Mode::GREEDY);
+
+    // Atlas tile index of every blocks faces, looked up once per block and face
+    class TileCache
+    {
+    public:
+        TileCache(int tilesPerRow)
+            : m_tilesPerRow(tilesPerRow)
+        {
+            // Room for every block there is right now so it doesn't grow while meshing
+            m_tiles.reserve(64 * 6);
+        }
+
+        int get(uint16_t block, Cube::CubeFace face)
+        {
+            const size_t key = (size_t)block * 6 + (size_t)face;
+            if (key >= m_tiles.size())
+                m_tiles.resize(key + 1, -1);
+
+            int& tile = m_tiles[key];
+            if (tile < 0)
+            {
+                glm::ivec2 coords = Blocks::getTextureTile((Blocks::BLOCK)block, face);
+                tile = coords.x + coords.y * m_tilesPerRow;
+                if (tile >= ChunkVertex::MAX_TILES)
+                {
+                #ifdef DEBUG
+                    printf("Atlas tile %d doesn't fit into a chunk vertex\n", tile);
+                #endif
+                    tile = 0;
+                }
+            }
+            return tile;
+        }
+
+    private:
+        int              m_tilesPerRow;
+        std::vector<int> m_tiles;
+    };
+
+    // How a unit face maps onto the axes, u and v are the texture axes
+    struct FaceAxes
+    {
+        Cube::CubeFace cubeface;
+        glm::ivec3     corners[4];  // Corners of the unit face
+        int            normal;
+        int            u;
+        int            v;
+    };
+
+    FaceAxes computeFaceAxes(Cube::CubeFace cubeface)
+    {
+        FaceAxes axes;
+        axes.cubeface = cubeface;
+
+        const Cube::Face face = Cube::getCubeFace(cubeface);
+        const GLfloat* p = face.verticies.data();
+        for (int i = 0; i < 4; i++)
+            axes.corners[i] = glm::ivec3(p[i * 3 + 0], p[i * 3 + 1], p[i * 3 + 2]);
+
+        // Texture coordinates go (0, 0) (0, 1) (1, 1) (1, 0) so v changes from the
+        // first to the second vertex and u from the second to the third
+        for (int axis = 0; axis < 3; axis++)
+        {
+            if (p[0 + axis] != p[3 + axis]) axes.v = axis;
+            if (p[3 + axis] != p[6 + axis]) axes.u = axis;
+        }
+        axes.normal = 3 - axes.u - axes.v;
+        return axes;
+    }
+
+    // Cube::getCubeFace() allocates its vectors on every call, so the axes are only worked out once
+    const FaceAxes& getFaceAxes(Cube::CubeFace cubeface)
+    {
+        static const std::array<FaceAxes, 6> faces = []()
+        {
+            std::array<FaceAxes, 6> result;
+            for (int face = 0; face < 6; face++)
+                result[face] = computeFaceAxes((Cube::CubeFace)face);
+            return result;
+        }();
+        return faces[(int)cubeface];
+    }
+
+    /**
+     * Desc. Adds a quad covering extent blocks from the block at base
+     *
+     * Note. extent along the normal is 1, the unit face is stretched over the other two axes
+    */
+    void addQuad(MeshData& out, const FaceAxes& axes, const glm::ivec3& base, const glm::ivec3& extent, int tile)
+    {
+        for (int i = 0; i < 4; i++)
+        {
+            const glm::ivec3 corner = base + axes.corners[i] * extent;
+            out.verticies.push_back(ChunkVertex::pack(corner.x, corner.y, corner.z, axes.cubeface, tile));
+        }
+    }
+
+    void buildNaive(const ChunkSnapshot& snapshot, const uint8_t* masks, TileCache& tiles, MeshData& out)
+    {
+        const glm::ivec3 size = snapshot.size;
+
+        FaceAxes axes[6];
+        for (int face = 0; face < 6; face++)
+            axes[face] = getFaceAxes((Cube::CubeFace)face);
+
+        int i = 0;
+        for (int x = 0; x < size.x; x++)
+            for (int y = 0; y < size.y; y++)
+                for (int z = 0; z < size.z; z++, i++)
+                {
+                    uint8_t mask = masks[i];
+                    for (int face = 0; mask != 0; face++, mask >>= 1)
+                        if (mask & 1)
+                            addQuad(out, axes[face], snapshot.origin + glm::ivec3(x, y, z), { 1, 1, 1 }, tiles.get(snapshot.get(x, y, z), (Cube::CubeFace)face));
+                }
+    }
+
+    /**
+     * Desc. Merges the visible faces of every slice into rectangles
+     *
+     * Note. Every face direction is walked slice by slice along its normal. A slice
+     * is a grid of atlas tiles + 1 (0 = no face), rectangles are grown along a row
+     * first and then over the next rows as long as the whole span matches
+    */
+    void buildGreedy(const ChunkSnapshot& snapshot, const uint8_t* masks, TileCache& tiles, MeshData& out)
+    {
+        const glm::ivec3 size = snapshot.size;
+        thread_local std::vector<uint32_t> slice;
+
+        // Steps along every axis in the masks and in the padded blocks
+        const glm::ivec3 maskStride(size.y * size.z, size.z, 1);
+        const glm::ivec3 blockStride((size.y + 2) * (size.z + 2), size.z + 2, 1);
+        const uint16_t* blocks = &snapshot.blocks[snapshot.index(0, 0, 0)];
+
+        for (int face = 0; face < 6; face++)
+        {
+            const Cube::CubeFace cubeface = (Cube::CubeFace)face;
+            const FaceAxes& axes = getFaceAxes(cubeface);
+            const uint8_t bit = ChunkKernels::faceBit(cubeface);
+
+            // Rows of the slice run along the texture axis that is closer in memory
+            const int row = (maskStride[axes.u] < maskStride[axes.v]) ? axes.u : axes.v;
+            const int col = axes.u + axes.v - row;
+            const int rowSize = size[row];
+            const int colSize = size[col];
+            const int maskRow = maskStride[row];
+            const int blockRow = blockStride[row];
+
+            // Neighbouring blocks mostly have the same block so remember the last lookup
+            uint16_t lastBlock = ChunkSnapshot::NO_NEIGHBOUR;
+            uint32_t lastKey = 0;
+
+            slice.resize(rowSize * colSize);
+            for (int d = 0; d < size[axes.normal]; d++)
+            {
+                bool empty = true;
+                for (int c = 0; c < colSize; c++)
+                {
+                    const uint8_t*  m = masks + d * maskStride[axes.normal] + c * maskStride[col];
+                    const uint16_t* b = blocks + d * blockStride[axes.normal] + c * blockStride[col];
+                    uint32_t* keys = &slice[c * rowSize];
+
+                    // Most rows have no face at all, those are cleared without looking at the blocks
+                    uint8_t any = 0;
+                    for (int r = 0; r < rowSize; r++)
+                        any |= m[r * maskRow];
+                    if (!(any & bit))
+                    {
+                        std::fill_n(keys, rowSize, 0u);
+                        continue;
+                    }
+
+                    for (int r = 0; r < rowSize; r++)
+                    {
+                        if (!(m[r * maskRow] & bit))
+                        {
+                            keys[r] = 0;
+                            continue;
+                        }
+
+                        const uint16_t block = b[r * blockRow];
+                        if (block != lastBlock)
+                        {
+                            lastBlock = block;
+                            lastKey = 1 + tiles.get(block, cubeface);
+                        }
+                        keys[r] = lastKey;
+                    }
+                    empty = false;
+                }
+                if (empty)
+                    continue;
+
+                for (int c = 0; c < colSize; c++)
+                    for (int r = 0; r < rowSize; )
+                    {
+                        const uint32_t key = slice[c * rowSize + r];
+                        if (key == 0)
+                        {
+                            r++;
+                            continue;
+                        }
+
+                        int width = 1;
+                        while (r + width < rowSize && slice[c * rowSize + r + width] == key)
+                            width++;
+
+                        int height = 1;
+                        for (; c + height < colSize; height++)
+                        {
+                            const uint32_t* keys = &slice[(c + height) * rowSize + r];
+                            int k = 0;
+                            while (k < width && keys[k] == key)
+                                k++;
+                            if (k < width)
+                                break;
+                        }
+
+                        for (int h = 0; h < height; h++)
+                            std::fill_n(&slice[(c + h) * rowSize + r], width, 0u);
+
+                        glm::ivec3 base, extent(1);
+                        base[axes.normal] = d;
+                        base[row] = r;
+                        base[col] = c;
+                        extent[row] = width;
+                        extent[col] = height;
+                        addQuad(out, axes, snapshot.origin + base, extent, key - 1);
+
+                        r += width;
+                    }
+            }
+        }
+    }
+}
+
+void MeshData::clear()
+{
+    verticies.clear();
+}
+
+size_t MeshData::getQuadCount() const
+{
+    return verticies.size() / 4;
+}
+
+size_t MeshData::getMemoryUsage() const
+{
+    return verticies.size() * sizeof(GLuint);
+}
+
+void ChunkMesher::setMode(Mode mode)
+{
+    meshMode = mode;
+}
+
+ChunkMesher::Mode ChunkMesher::getMode()
+{
+    return meshMode;
+}
+
+void ChunkMesher::build(const ChunkSnapshot& snapshot, int tilesPerRow, MeshData& out)
+{
+    build(snapshot, tilesPerRow, out, getMode());
+}
+
+void ChunkMesher::build(const ChunkSnapshot& snapshot, int tilesPerRow, MeshData& out, Mode mode)
+{
+    out.clear();
+
+    const glm::ivec3 size = snapshot.size;
+    const int count = size.x * size.y * size.z;
+
+    // Face masks of every block, the compiled kernel is used if there is one for our size
+    // and the snapshot has the occupancy rows it reads. Scratch space is per thread so meshing on several threads doesn't share it
+    thread_local std::vector<uint8_t> masks;
+    masks.resize(count);
+
+    ChunkKernels::FaceMaskKernel kernel = snapshot.rows.empty() ? nullptr : ChunkKernels::getFaceMaskKernel(size);
+    if (kernel != nullptr)
+        kernel(snapshot.blocks.data(), snapshot.rows.data(), masks.data());
+    else
+        ChunkKernels::faceMasks(size, snapshot.blocks.data(), masks.data());
+
+    TileCache tiles(tilesPerRow);
+    if (mode == Mode::GREEDY)
+        buildGreedy(snapshot, masks.data(), tiles, out);
+    else
+        buildNaive(snapshot, masks.data(), tiles, out);
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include <vector>
+#include <glm/glm.hpp>
+#include "../gl/glObjects.h"
+#include "../util/cube.h"
+#include "chunksnapshot.h"
+
+/*
+    Chunk vertex format
+    -------------------
+    Every vertex is a single 32-bit word:
+
+        bits  0 -  6   x inside of the chunk (0 - 127)
+        bits  7 - 15   y inside of the chunk (0 - 511)
+        bits 16 - 22   z inside of the chunk (0 - 127)
+        bits 23 - 25   face (Cube::CubeFace)
+        bits 26 - 31   atlas tile, tile x + tile y * tiles per row
+
+    That covers every size ChunkKernels has a kernel for and an atlas of 8x8 tiles.
+    resources/shaders/chunk.vert decodes it, the texture coordinates are the position
+    along the two texture axes of the face so a face merged over several blocks
+    repeats the texture once per block. The axes of every face are a table in the
+    shader taken from Cube::getCubeFace().
+*/
+namespace ChunkVertex
+{
+    const int MAX_X = 127;
+    const int MAX_Y = 511;
+    const int MAX_Z = 127;
+    const int MAX_TILES = 64;
+
+    inline GLuint pack(int x, int y, int z, Cube::CubeFace face, int tile)
+    {
+        return (GLuint)x | ((GLuint)y << 7) | ((GLuint)z << 16) | ((GLuint)face << 23) | ((GLuint)tile << 26);
+    }
+
+    inline glm::ivec3 getPosition(GLuint vertex) { return { vertex & 0x7F, (vertex >> 7) & 0x1FF, (vertex >> 16) & 0x7F }; }
+    inline Cube::CubeFace getFace(GLuint vertex) { return (Cube::CubeFace)((vertex >> 23) & 0x7); }
+    inline int            getTile(GLuint vertex) { return (int)(vertex >> 26); }
+};
+
+// Vertex data of a chunk mesh before it's uploaded to the GPU. Every 4 verticies are
+// a quad, they are drawn with the shared index buffer of Renderer::RenderQuads()
+struct MeshData
+{
+    std::vector<GLuint> verticies;
+
+    void clear();
+    size_t getQuadCount() const;
+    size_t getMemoryUsage() const;
+};
+
+namespace ChunkMesher
+{
+    enum class Mode
+    {
+        NAIVE,  // One quad per visible block face
+        GREEDY  // Neighbouring faces with the same texture are merged into rectangles
+    };
+
+    // Mode used by build(), can be changed from any thread
+    void setMode(Mode mode);
+    Mode getMode();
+
+    // Builds the mesh of a snapshot into out, only reads the snapshot so it can run
+    // off the main thread and without a GL context. tilesPerRow is the width of the
+    // texture atlas in tiles. Positions are relative to the chunk so a section
+    // snapshot gives the quads of that section
+    void build(const ChunkSnapshot& snapshot, int tilesPerRow, MeshData& out);
+    void build(const ChunkSnapshot& snapshot, int tilesPerRow, MeshData& out, Mode mode);
+};
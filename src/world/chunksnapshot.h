@@ -0,0 +1,57 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+/*
+    Chunk snapshot
+    --------------
+    Copy of a chunks blocks padded with a one block apron on every side that holds
+    the border blocks of the six neighbours, (x, y, z) goes from -1 to size.
+
+    The apron means every block inside of the chunk has all six neighbours in the
+    same array, so the mesher needs no border checks and never touches another chunk.
+    A snapshot doesn't point at any chunk so it can be meshed on another thread.
+
+    Sides without a (resident) neighbour and the apron edges and corners hold
+    NO_NEIGHBOUR, it isn't AIR so no faces are made against it.
+
+    The snapshot of a mesh section only holds some rows of the chunk, origin is where
+    its (0, 0, 0) is in the chunk and the rows above and below are the apron.
+
+    For chunks up to 64 blocks deep the solid bits of every padded row (x, y) along z
+    are copied from the occupancy masks too (see OccupancyMask), the face mask kernels
+    read them instead of packing the blocks. Missing neighbours count as solid there.
+*/
+struct ChunkSnapshot
+{
+    static constexpr uint16_t NO_NEIGHBOUR = 0xFFFF;
+
+    glm::ivec3            size;     // Size of the chunk (or section) without the apron
+    glm::ivec3            origin = glm::ivec3(0);  // Where (0, 0, 0) is inside of the chunk
+    uint32_t              version;  // Chunk::getVersion() when the snapshot was taken
+    std::vector<uint16_t> blocks;   // x major, ((x * YSIZE + y) * ZSIZE) + z of the padded size
+    std::vector<uint64_t> rows;     // Solid bits of the padded rows, (x * YSIZE + y). Empty if not known
+
+    void resize(glm::ivec3 chunkSize)
+    {
+        size = chunkSize;
+        blocks.assign((size.x + 2) * (size.y + 2) * (size.z + 2), NO_NEIGHBOUR);
+        rows.clear();
+    }
+
+    int rowIndex(int x, int y) const
+    {
+        return (x + 1) * (size.y + 2) + (y + 1);
+    }
+
+    int index(int x, int y, int z) const
+    {
+        return ((x + 1) * (size.y + 2) + (y + 1)) * (size.z + 2) + (z + 1);
+    }
+
+    uint16_t get(int x, int y, int z) const
+    {
+        return blocks[index(x, y, z)];
+    }
+};
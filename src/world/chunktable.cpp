@@ -0,0 +1,108 @@
+#include "chunktable.h"
+
+#include <new>
+
+ChunkTable::ChunkTable(gl::TextureAtlas* atlas, size_t maxFree)
+    : m_atlas(atlas)
+    , m_maxFree(maxFree)
+    , m_meshesAllocated(0)
+    , m_reused(0)
+{
+}
+
+ChunkTable::~ChunkTable()
+{
+    for (uint32_t i = 0; i < (uint32_t)m_generations.size(); i++)
+        slot(i)->~Chunk();
+}
+
+/**
+ * Desc. Creates an empty chunk at the given position and returns its handle,
+ * the slot of a destroyed chunk is reused if there is one
+*/
+ChunkHandle ChunkTable::create(glm::vec3 position, glm::uvec3 size)
+{
+    uint32_t index;
+    if (!m_free.empty())
+    {
+        index = m_free.back();
+        m_free.pop_back();
+
+        slot(index)->reset(position, size);
+        m_reused++;
+    }
+    else
+    {
+        index = (uint32_t)m_generations.size();
+        if (index == m_slabs.size() * SLAB_SIZE)
+            m_slabs.emplace_back(new uint8_t[SLAB_SIZE * sizeof(Chunk)]);
+
+        new (slot(index)) Chunk(position, size, m_atlas);
+        m_generations.push_back(0);
+    }
+
+    ChunkHandle handle = { index, ++m_generations[index] };
+    slot(index)->setHandle(this, handle);
+    return handle;
+}
+
+/**
+ * Desc. Destroys the chunk, every handle to it resolves to nullptr from now on
+*/
+void ChunkTable::destroy(ChunkHandle handle)
+{
+    Chunk* chunk = get(handle);
+    if (chunk == nullptr)
+        return;
+
+    m_generations[handle.index]++;
+
+    if (chunk->getMesh() != nullptr)
+        releaseMesh(chunk->takeMesh());
+
+    // Don't hold on to more buffers than we will likely need again
+    if (m_free.size() >= m_maxFree)
+        chunk->evict();
+
+    m_free.push_back(handle.index);
+}
+
+std::unique_ptr<ChunkMesh> ChunkTable::acquireMesh()
+{
+    if (!m_freeMeshes.empty())
+    {
+        auto mesh = std::move(m_freeMeshes.back());
+        m_freeMeshes.pop_back();
+        return mesh;
+    }
+
+    m_meshesAllocated++;
+    return std::make_unique<ChunkMesh>(m_atlas);
+}
+
+void ChunkTable::releaseMesh(std::unique_ptr<ChunkMesh> mesh)
+{
+    // The buffers are kept, the next chunk using the mesh uploads into them
+    if (m_freeMeshes.size() < m_maxFree)
+        m_freeMeshes.push_back(std::move(mesh));
+}
+
+size_t ChunkTable::getAllocated() const
+{
+    return m_generations.size();
+}
+
+size_t ChunkTable::getMeshesAllocated() const
+{
+    return m_meshesAllocated;
+}
+
+size_t ChunkTable::getReused() const
+{
+    return m_reused;
+}
+
+size_t ChunkTable::getFreeCount() const
+{
+    return m_free.size();
+}
@@ -0,0 +1,77 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <glm/glm.hpp>
+#include "chunk.h"
+
+/*
+    Chunk table
+    -----------
+    Owns every chunk and hands out generational handles to them. A handle is the
+    index of the chunks slot plus the generation of the slot when the chunk was
+    created, unloading a chunk bumps the generation so every handle still pointing
+    at it resolves to nullptr instead of dangling. Chunks link their neighbours
+    through handles so unloading never has to unlink anything.
+
+    Streaming loads and unloads chunks all the time, instead of allocating a new chunk
+    (and its block array) for every load, the slots of destroyed chunks are kept on a
+    free list and reused by create(). Meshes (VAO, VBOs and EBO) are recycled the same
+    way with acquireMesh().
+
+    Chunks are constructed inside of slabs of SLAB_SIZE chunks so the table only
+    allocates once every SLAB_SIZE chunks, the generation of every slot is kept in one
+    contiguous array. A free chunk keeps its block buffer, once more than maxFree
+    chunks are free the extra ones drop their buffers.
+*/
+class ChunkTable
+{
+public:
+    ChunkTable(gl::TextureAtlas* atlas, size_t maxFree = 256);
+    ~ChunkTable();
+
+    ChunkTable(const ChunkTable&) = delete;
+    ChunkTable& operator=(const ChunkTable&) = delete;
+
+    ChunkHandle create(glm::vec3 position, glm::uvec3 size);
+    void        destroy(ChunkHandle handle);
+
+    // Returns nullptr if the chunk was destroyed
+    Chunk* get(ChunkHandle handle) const
+    {
+        if (handle.index >= m_generations.size() || m_generations[handle.index] != handle.generation)
+            return nullptr;
+
+        return slot(handle.index);
+    }
+
+    // Needs a GL context
+    std::unique_ptr<ChunkMesh> acquireMesh();
+    void                       releaseMesh(std::unique_ptr<ChunkMesh> mesh);
+
+    size_t getAllocated() const;
+    size_t getMeshesAllocated() const;
+    size_t getReused() const;
+    size_t getFreeCount() const;
+
+private:
+    static const size_t SLAB_SIZE = 64;
+
+    gl::TextureAtlas*                       m_atlas;
+    size_t                                  m_maxFree;
+
+    std::vector<std::unique_ptr<uint8_t[]>> m_slabs;
+    std::vector<uint32_t>                   m_generations; // odd while the slot holds a live chunk
+    std::vector<uint32_t>                   m_free;
+
+    std::vector<std::unique_ptr<ChunkMesh>> m_freeMeshes;
+    size_t                                  m_meshesAllocated;
+
+    size_t                                  m_reused;
+
+    Chunk* slot(uint32_t index) const
+    {
+        return reinterpret_cast<Chunk*>(m_slabs[index / SLAB_SIZE].get()) + index % SLAB_SIZE;
+    }
+};
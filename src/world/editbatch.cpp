@@ -0,0 +1,153 @@
+#include "editbatch.h"
+
+#include <algorithm>
+#include "blocks.h"
+#include "worldview.h"
+#include "../util/math.h"
+
+EditBatch::EditBatch(ChunkManager& manager)
+    : m_manager(manager)
+    , m_size(manager.chunkSize)
+    , m_changed(0)
+{
+}
+
+EditBatch::~EditBatch()
+{
+    commit();
+}
+
+/**
+ * Desc. Calls blockAt(x, y, z, block) with the global position of every loaded block
+ * in [min, max) and sets the block to what it returns, -1 keeps the block
+ *
+ * Note. The box is split into one box per chunk like WorldView::getRegion()
+*/
+template<typename F>
+void EditBatch::editRegion(const glm::ivec3& min, const glm::ivec3& max, F&& blockAt)
+{
+    // Steps from start to the end of its chunk or the end of the box
+    auto spanEnd = [](int start, int end, int size)
+    {
+        return std::min(end, (Math::floorDiv(start, size) + 1) * size);
+    };
+
+    for (int x0 = min.x; x0 < max.x; x0 = spanEnd(x0, max.x, m_size.x))
+        for (int y0 = min.y; y0 < max.y; y0 = spanEnd(y0, max.y, m_size.y))
+            for (int z0 = min.z; z0 < max.z; z0 = spanEnd(z0, max.z, m_size.z))
+            {
+                const glm::ivec3 end(spanEnd(x0, max.x, m_size.x), spanEnd(y0, max.y, m_size.y), spanEnd(z0, max.z, m_size.z));
+
+                ChunkPos pos = m_manager.toChunkPos(x0, y0, z0);
+                Chunk* chunk = m_manager.getChunk(pos);
+                if (chunk == nullptr)
+                    continue;
+
+                const glm::ivec3 origin = glm::ivec3(pos) * m_size;
+                const glm::ivec3 localMin = glm::ivec3(x0, y0, z0) - origin;
+                const glm::ivec3 localMax = end - origin;
+
+                int changed = chunk->editBox(localMin, localMax, [&](int x, int y, int z, int current)
+                {
+                    int block = blockAt(x + origin.x, y + origin.y, z + origin.z, current);
+                    if (block >= 0 && block != current)
+                        m_manager.journal.record(pos, { x, y, z }, (uint16_t)current, (uint16_t)block);
+                    return block;
+                });
+                if (changed == 0)
+                    continue;
+
+                // The box decides which sections and neighbours are remeshed
+                auto dirty = m_dirty.find(chunk);
+                if (dirty == m_dirty.end())
+                    m_dirty.emplace(chunk, DirtyBox{ localMin, localMax });
+                else
+                {
+                    dirty->second.min = glm::min(dirty->second.min, localMin);
+                    dirty->second.max = glm::max(dirty->second.max, localMax);
+                }
+                m_changed += changed;
+            }
+}
+
+void EditBatch::setBlock(int x, int y, int z, int blockid)
+{
+    editRegion({ x, y, z }, { x + 1, y + 1, z + 1 }, [&](int, int, int, int) { return blockid; });
+}
+
+void EditBatch::setBlock(const glm::vec3& position, int blockid)
+{
+    glm::ivec3 block = glm::floor(position);
+    setBlock(block.x, block.y, block.z, blockid);
+}
+
+void EditBatch::fillBox(const glm::ivec3& min, const glm::ivec3& max, int blockid)
+{
+    editRegion(min, max, [&](int, int, int, int) { return blockid; });
+}
+
+void EditBatch::fillSphere(const glm::ivec3& centre, int radius, int blockid)
+{
+    const int radius2 = radius * radius;
+    editRegion(centre - radius, centre + radius + 1, [&](int x, int y, int z, int)
+    {
+        glm::ivec3 d = glm::ivec3(x, y, z) - centre;
+        return (d.x * d.x + d.y * d.y + d.z * d.z <= radius2) ? blockid : -1;
+    });
+}
+
+void EditBatch::replace(const glm::ivec3& min, const glm::ivec3& max, int from, int to)
+{
+    editRegion(min, max, [&](int, int, int, int block) { return (block == from) ? to : -1; });
+}
+
+void EditBatch::copy(const glm::ivec3& min, const glm::ivec3& max, BlockVolume& out)
+{
+    out.size = glm::max(max - min, glm::ivec3(0));
+    out.blocks.resize(out.size.x * out.size.y * out.size.z);
+
+    WorldView world(m_manager);
+    world.getRegion(min, max, out.blocks.data());
+}
+
+void EditBatch::paste(const BlockVolume& volume, const glm::ivec3& origin, bool skipAir)
+{
+    editRegion(origin, origin + volume.size, [&](int x, int y, int z, int)
+    {
+        int block = volume.blocks[volume.index(x - origin.x, y - origin.y, z - origin.z)];
+        return (skipAir && block == Blocks::AIR) ? -1 : block;
+    });
+}
+
+/**
+ * Desc. Queues every edited chunk and the neighbours on the other side of
+ * the borders that were edited for a remesh
+ *
+ * Note. The ChunkManager remeshes them once in its next Update() however
+ * many batches and edits touched them
+*/
+void EditBatch::commit()
+{
+    for (auto& dirty : m_dirty)
+    {
+        // Big edits leave palette entries behind that nothing uses anymore
+        dirty.first->compact();
+        m_manager.markDirty(dirty.first, dirty.second.min, dirty.second.max);
+    }
+
+    // Everything since the last commit is undone in one go
+    m_manager.journal.closeGroup();
+
+#ifdef DEBUG
+    if (!m_dirty.empty())
+        printf("Edit batch: %d blocks in %d chunks\n", m_changed, (int)m_dirty.size());
+#endif
+
+    m_dirty.clear();
+    m_changed = 0;
+}
+
+int EditBatch::getChanged() const
+{
+    return m_changed;
+}
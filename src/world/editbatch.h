@@ -0,0 +1,76 @@
+#pragma once
+#include <unordered_map>
+#include <vector>
+#include <glm/glm.hpp>
+#include "chunkmanager.h"
+
+// Blocks copied out of the world, x major ((x * YSIZE + y) * ZSIZE) + z like WorldView::getRegion()
+// Note. Blocks of chunks that weren't loaded are -1 and are skipped when pasting
+struct BlockVolume
+{
+    glm::ivec3       size = glm::ivec3(0);
+    std::vector<int> blocks;
+
+    int index(int x, int y, int z) const { return (x * size.y + y) * size.z + z; }
+};
+
+/*
+    Edit batch
+    ----------
+    Collects many block changes and marks every affected chunk dirty only once when
+    the batch is committed, the ChunkManager then remeshes it in its next Update().
+
+    Every operation is split into the boxes it covers in each chunk and written chunk
+    by chunk, so a chunk is looked up once per operation and its blocks are visited
+    in order. Changed blocks are recorded as edits just like setBlockGlobal() does,
+    and in the ChunkManagers journal so a commit can be undone as a whole.
+
+    Neighbours are only marked if the edits reached the border they share with an
+    edited chunk, and only the sections around the edited rows are remeshed.
+
+    Note. Like a WorldView a batch is meant to live for one piece of work, the
+    destructor commits whatever wasn't committed yet
+*/
+class EditBatch
+{
+public:
+    EditBatch(ChunkManager& manager);
+    ~EditBatch();
+
+    EditBatch(const EditBatch&) = delete;
+    EditBatch& operator=(const EditBatch&) = delete;
+
+    void setBlock(int x, int y, int z, int blockid);
+    void setBlock(const glm::vec3& position, int blockid);
+
+    // Boxes are [min, max)
+    void fillBox(const glm::ivec3& min, const glm::ivec3& max, int blockid);
+    void fillSphere(const glm::ivec3& centre, int radius, int blockid);
+    void replace(const glm::ivec3& min, const glm::ivec3& max, int from, int to);
+
+    void copy(const glm::ivec3& min, const glm::ivec3& max, BlockVolume& out);
+    // Places the volume with its first block at origin, AIR in the volume is skipped if skipAir is set
+    void paste(const BlockVolume& volume, const glm::ivec3& origin, bool skipAir = false);
+
+    // Marks the edited chunks and the neighbours they changed a border of dirty
+    void commit();
+
+    // Blocks changed since the last commit
+    int getChanged() const;
+
+private:
+    ChunkManager&   m_manager;
+    glm::ivec3      m_size;
+
+    // Edited chunks and the local box [min, max) around their edits
+    struct DirtyBox
+    {
+        glm::ivec3 min;
+        glm::ivec3 max;
+    };
+    std::unordered_map<Chunk*, DirtyBox> m_dirty;
+    int             m_changed;
+
+    template<typename F>
+    void editRegion(const glm::ivec3& min, const glm::ivec3& max, F&& blockAt);
+};
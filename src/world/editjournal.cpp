@@ -0,0 +1,242 @@
+#include "editjournal.h"
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+
+EditJournal::EditJournal()
+    : m_runStart(0)
+    , m_runPos(0, 0, 0)
+    , m_memoryUsed(0)
+    , m_memoryLimit(16 * 1024 * 1024)
+    , m_spilled(0)
+    , m_spillSize(0)
+{
+}
+
+EditJournal::~EditJournal()
+{
+    if (!m_spillPath.empty())
+    {
+        std::error_code error;
+        std::filesystem::remove(m_spillPath, error);
+    }
+}
+
+void EditJournal::setMemoryLimit(size_t bytes)
+{
+    m_memoryLimit = bytes;
+    spill();
+}
+
+void EditJournal::setSpillFile(const std::string& path)
+{
+    clear();
+    m_spillPath = path;
+    std::ofstream(m_spillPath, std::ios::binary | std::ios::trunc);
+}
+
+/**
+ * Desc. Appends a change to the group that is being recorded
+ *
+ * Note. Changes to the same chunk in a row share a run header
+*/
+void EditJournal::record(const ChunkPos& pos, const glm::ivec3& local, uint16_t before, uint16_t after)
+{
+    if (m_current.empty() || pos != m_runPos)
+    {
+        m_runStart = m_current.size();
+        m_runPos = pos;
+
+        const int64_t  xyz[3] = { pos.x, pos.y, pos.z };
+        const uint32_t count = 0;
+        m_current.resize(m_runStart + RUN_HEADER);
+        memcpy(&m_current[m_runStart], xyz, sizeof(xyz));
+        memcpy(&m_current[m_runStart + sizeof(xyz)], &count, sizeof(count));
+    }
+
+    Change change = { (uint8_t)local.x, (uint8_t)local.y, (uint8_t)local.z, 0, before, after };
+    size_t offset = m_current.size();
+    m_current.resize(offset + sizeof(change));
+    memcpy(&m_current[offset], &change, sizeof(change));
+
+    uint32_t count;
+    uint8_t* countPtr = &m_current[m_runStart + 3 * sizeof(int64_t)];
+    memcpy(&count, countPtr, sizeof(count));
+    count++;
+    memcpy(countPtr, &count, sizeof(count));
+}
+
+/**
+ * Desc. Moves the recorded group onto the undo stack, a new edit can't be redone
+ * past so the redo stack is cleared
+*/
+void EditJournal::closeGroup()
+{
+    if (m_current.empty())
+        return;
+
+    for (auto& group : m_redo)
+        m_memoryUsed -= group.capacity();
+    m_redo.clear();
+
+    m_current.shrink_to_fit();
+    m_memoryUsed += m_current.capacity();
+    m_undo.push_back(std::move(m_current));
+    m_current = std::vector<uint8_t>();
+
+    spill();
+}
+
+bool EditJournal::popUndo(std::vector<uint8_t>& group)
+{
+    closeGroup();
+
+    if (m_undo.empty())
+        return unspill(group);
+
+    group = std::move(m_undo.back());
+    m_undo.pop_back();
+    m_memoryUsed -= group.capacity();
+    return true;
+}
+
+bool EditJournal::popRedo(std::vector<uint8_t>& group)
+{
+    closeGroup();
+
+    if (m_redo.empty())
+        return false;
+
+    group = std::move(m_redo.back());
+    m_redo.pop_back();
+    m_memoryUsed -= group.capacity();
+    return true;
+}
+
+void EditJournal::pushUndo(std::vector<uint8_t>& group)
+{
+    m_memoryUsed += group.capacity();
+    m_undo.push_back(std::move(group));
+    spill();
+}
+
+void EditJournal::pushRedo(std::vector<uint8_t>& group)
+{
+    m_memoryUsed += group.capacity();
+    m_redo.push_back(std::move(group));
+    spill();
+}
+
+void EditJournal::clear()
+{
+    m_current.clear();
+    m_undo.clear();
+    m_redo.clear();
+    m_memoryUsed = 0;
+
+    m_spilled = 0;
+    m_spillSize = 0;
+    if (!m_spillPath.empty())
+        std::ofstream(m_spillPath, std::ios::binary | std::ios::trunc);
+}
+
+size_t EditJournal::getUndoCount() const
+{
+    return m_undo.size() + m_spilled + (m_current.empty() ? 0 : 1);
+}
+
+size_t EditJournal::getRedoCount() const
+{
+    return m_redo.size();
+}
+
+size_t EditJournal::getMemoryUsage() const
+{
+    return sizeof(EditJournal) + m_memoryUsed + m_current.capacity();
+}
+
+/**
+ * Desc. Moves the oldest undo groups to the spill file until the groups
+ * in memory fit the memory limit, then drops the oldest redo groups
+ *
+ * Note. Every group is followed by its size so the file can be read back to front
+*/
+void EditJournal::spill()
+{
+    if (m_memoryUsed <= m_memoryLimit)
+        return;
+
+    std::ofstream out;
+    if (!m_spillPath.empty() && !m_undo.empty())
+        out.open(m_spillPath, std::ios::binary | std::ios::app);
+
+    while (m_memoryUsed > m_memoryLimit && !m_undo.empty())
+    {
+        std::vector<uint8_t>& group = m_undo.front();
+        if (out.is_open())
+        {
+            uint32_t size = (uint32_t)group.size();
+            out.write((const char*)group.data(), group.size());
+            out.write((const char*)&size, sizeof(size));
+            m_spillSize += group.size() + sizeof(size);
+            m_spilled++;
+        }
+
+        m_memoryUsed -= group.capacity();
+        m_undo.pop_front();
+    }
+
+    // Undoing a lot moves the groups onto the redo stack, they count against the limit as well
+    while (m_memoryUsed > m_memoryLimit && !m_redo.empty())
+    {
+        m_memoryUsed -= m_redo.front().capacity();
+        m_redo.pop_front();
+    }
+
+#ifdef DEBUG
+    printf("Edit journal: %zu groups in memory, %zu spilled (%llu bytes)\n",
+        m_undo.size(), m_spilled, (unsigned long long)m_spillSize);
+#endif
+}
+
+/**
+ * Desc. Reads the newest spilled group back and cuts it off of the spill file
+*/
+bool EditJournal::unspill(std::vector<uint8_t>& group)
+{
+    if (m_spilled == 0)
+        return false;
+
+    std::ifstream in(m_spillPath, std::ios::binary);
+    uint32_t size = 0;
+    if (in.is_open())
+    {
+        in.seekg(m_spillSize - sizeof(size));
+        in.read((char*)&size, sizeof(size));
+        if (in && size + sizeof(size) <= m_spillSize)
+        {
+            group.resize(size);
+            in.seekg(m_spillSize - sizeof(size) - size);
+            in.read((char*)group.data(), size);
+        }
+        else
+            in.setstate(std::ios::failbit);
+    }
+
+    if (!in.is_open() || !in)
+    {
+        printf("[EditJournal]: Could not read spill file %s\n", m_spillPath.c_str());
+        m_spilled = 0;
+        m_spillSize = 0;
+        return false;
+    }
+    in.close();
+
+    m_spillSize -= size + sizeof(size);
+    m_spilled--;
+
+    std::error_code error;
+    std::filesystem::resize_file(m_spillPath, m_spillSize, error);
+    return true;
+}
@@ -0,0 +1,143 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+#include "chunkmap.h"
+
+/*
+    Edit journal
+    ------------
+    Remembers every block change so it can be undone and redone. Changes are grouped,
+    a group is one setBlockGlobal() or one committed EditBatch and is undone as a whole.
+
+    Group layout, runs of changes in the same chunk
+    - int64_t  chunk x, y, z
+    - uint32_t count
+    - Change   changes[count]
+
+    Appending a change is a compare with the chunk of the current run and an 8 byte copy.
+    Closed groups are kept in memory until the undo and redo groups together use more
+    than the memory limit, the oldest undo groups are then moved to the spill file and
+    read back once everything newer was undone. Without a spill file the oldest groups
+    are dropped. If there is nothing left to undo in memory the redo groups that would
+    be redone last are dropped.
+
+    Note. Local positions are stored in a byte per axis, chunks are at most 256 blocks
+    along every axis (see ChunkKernels::isSupported())
+*/
+class EditJournal
+{
+public:
+    struct Change
+    {
+        uint8_t  x, y, z;
+        uint8_t  unused;
+        uint16_t before;
+        uint16_t after;
+    };
+
+    EditJournal();
+    ~EditJournal();
+
+    EditJournal(const EditJournal&) = delete;
+    EditJournal& operator=(const EditJournal&) = delete;
+
+    void setMemoryLimit(size_t bytes);
+    // The file is only used for this session, it's cleared when it's set
+    void setSpillFile(const std::string& path);
+
+    void record(const ChunkPos& pos, const glm::ivec3& local, uint16_t before, uint16_t after);
+    // Ends the group that is being recorded, empty groups are ignored
+    void closeGroup();
+
+    // Takes the newest group off of the undo or redo stack, returns false if there is none
+    bool popUndo(std::vector<uint8_t>& group);
+    bool popRedo(std::vector<uint8_t>& group);
+    // Undone groups are pushed to the redo stack and redone ones back to the undo stack
+    void pushUndo(std::vector<uint8_t>& group);
+    void pushRedo(std::vector<uint8_t>& group);
+
+    void clear();
+
+    size_t getUndoCount() const;
+    size_t getRedoCount() const;
+    size_t getMemoryUsage() const;
+
+    // Calls f(pos, change) for every change of the group in the order it was recorded
+    template<typename F>
+    static void forEachChange(const std::vector<uint8_t>& group, F&& f)
+    {
+        const uint8_t* p = group.data();
+        const uint8_t* end = p + group.size();
+        while (p < end)
+        {
+            int64_t  xyz[3];
+            uint32_t count;
+            memcpy(xyz, p, sizeof(xyz));        p += sizeof(xyz);
+            memcpy(&count, p, sizeof(count));   p += sizeof(count);
+
+            const ChunkPos pos(xyz[0], xyz[1], xyz[2]);
+            for (uint32_t i = 0; i < count; i++, p += sizeof(Change))
+            {
+                Change change;
+                memcpy(&change, p, sizeof(change));
+                f(pos, change);
+            }
+        }
+    }
+
+    // Same as forEachChange() from the newest change to the oldest one, for undoing a group
+    // that changed a block more than once
+    template<typename F>
+    static void forEachChangeReverse(const std::vector<uint8_t>& group, F&& f)
+    {
+        // Runs can only be found from the front
+        std::vector<size_t> runs;
+        for (size_t offset = 0; offset < group.size(); )
+        {
+            uint32_t count;
+            memcpy(&count, group.data() + offset + 3 * sizeof(int64_t), sizeof(count));
+            runs.push_back(offset);
+            offset += RUN_HEADER + count * sizeof(Change);
+        }
+
+        for (size_t run = runs.size(); run-- > 0; )
+        {
+            const uint8_t* p = group.data() + runs[run];
+            int64_t  xyz[3];
+            uint32_t count;
+            memcpy(xyz, p, sizeof(xyz));        p += sizeof(xyz);
+            memcpy(&count, p, sizeof(count));   p += sizeof(count);
+
+            const ChunkPos pos(xyz[0], xyz[1], xyz[2]);
+            for (uint32_t i = count; i-- > 0; )
+            {
+                Change change;
+                memcpy(&change, p + i * sizeof(Change), sizeof(change));
+                f(pos, change);
+            }
+        }
+    }
+
+private:
+    static const size_t RUN_HEADER = 3 * sizeof(int64_t) + sizeof(uint32_t);
+
+    std::vector<uint8_t>                m_current;
+    size_t                              m_runStart;     // Offset of the current runs header in m_current
+    ChunkPos                            m_runPos;
+
+    std::deque<std::vector<uint8_t>>    m_undo;
+    std::deque<std::vector<uint8_t>>    m_redo;
+    size_t                              m_memoryUsed;
+    size_t                              m_memoryLimit;
+
+    std::string                         m_spillPath;
+    size_t                              m_spilled;      // Groups in the spill file
+    uint64_t                            m_spillSize;
+
+    void spill();
+    bool unspill(std::vector<uint8_t>& group);
+};
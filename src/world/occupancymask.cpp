@@ -0,0 +1,127 @@
+#include "occupancymask.h"
+
+#include "blocks.h"
+
+OccupancyMask::OccupancyMask(glm::uvec3 size)
+{
+    reset(size);
+}
+
+void OccupancyMask::reset(glm::uvec3 size, bool solid)
+{
+    m_size = glm::ivec3(size);
+    m_wordsPerRow = (m_size.z + 63) / 64;
+    m_uniformSolid = solid;
+    m_words.clear();
+}
+
+/**
+ * Desc. Sets every bit from the blocks
+ *
+ * Note. A uniform storage gives a uniform mask without words
+*/
+void OccupancyMask::build(const BlockStorage& blocks, const ChunkLayout& layout)
+{
+    if (blocks.isUniform())
+    {
+        reset(layout.getSize(), blocks.getUniformBlock() != Blocks::AIR);
+        return;
+    }
+
+    static thread_local std::vector<uint16_t> unpacked;
+    unpacked.resize(blocks.size());
+    blocks.unpack(unpacked.data());
+
+    m_words.assign(m_size.x * m_size.y * m_wordsPerRow, 0);
+    for (int i = 0; i < (int)unpacked.size(); i++)
+    {
+        if (unpacked[i] == Blocks::AIR)
+            continue;
+
+        glm::ivec3 p = layout.position(i);
+        m_words[row(p.x, p.y) + (p.z >> 6)] |= uint64_t(1) << (p.z & 63);
+    }
+}
+
+void OccupancyMask::set(int x, int y, int z, bool solid)
+{
+    if (m_words.empty())
+    {
+        if (solid == m_uniformSolid)
+            return;
+
+        // Only the bits inside of the chunk are set so shifting a row never brings in solid blocks
+        m_words.assign(m_size.x * m_size.y * m_wordsPerRow, 0);
+        if (m_uniformSolid)
+            for (int r = 0; r < m_size.x * m_size.y; r++)
+                for (int w = 0; w < m_wordsPerRow; w++)
+                    m_words[r * m_wordsPerRow + w] = fullRow(m_size.z - w * 64);
+    }
+
+    uint64_t& word = m_words[row(x, y) + (z >> 6)];
+    const uint64_t bit = uint64_t(1) << (z & 63);
+    word = solid ? (word | bit) : (word & ~bit);
+}
+
+bool OccupancyMask::isUniform() const
+{
+    return m_words.empty();
+}
+
+int OccupancyMask::getWordsPerRow() const
+{
+    return m_wordsPerRow;
+}
+
+/**
+ * Desc. Counts the faces of every solid block that touch an empty block
+ *
+ * Note. Back and front are shifts inside of a row (carrying over word borders),
+ * the other sides compare the row with the neighbouring rows word by word
+*/
+size_t OccupancyMask::countFaces() const
+{
+    if (m_words.empty())
+    {
+        if (!m_uniformSolid)
+            return 0;
+
+        // Only the outside of the chunk
+        return 2 * ((size_t)m_size.x * m_size.y + (size_t)m_size.y * m_size.z + (size_t)m_size.x * m_size.z);
+    }
+
+    size_t faces = 0;
+    const int words = m_wordsPerRow;
+
+    for (int x = 0; x < m_size.x; x++)
+        for (int y = 0; y < m_size.y; y++)
+        {
+            const uint64_t* r = &m_words[row(x, y)];
+            const uint64_t* left   = (x > 0)            ? &m_words[row(x - 1, y)] : nullptr;
+            const uint64_t* right  = (x < m_size.x - 1) ? &m_words[row(x + 1, y)] : nullptr;
+            const uint64_t* bottom = (y > 0)            ? &m_words[row(x, y - 1)] : nullptr;
+            const uint64_t* top    = (y < m_size.y - 1) ? &m_words[row(x, y + 1)] : nullptr;
+
+            for (int w = 0; w < words; w++)
+            {
+                const uint64_t solid = r[w];
+                if (solid == 0)
+                    continue;
+
+                // Bits past the end of the row are 0 so the last blocks get their face
+                const uint64_t back  = (solid << 1) | ((w > 0) ? r[w - 1] >> 63 : 0);
+                const uint64_t front = (solid >> 1) | ((w < words - 1) ? r[w + 1] << 63 : 0);
+
+                faces += popcount(solid & ~back) + popcount(solid & ~front);
+                faces += popcount(solid & ~(left   ? left[w]   : 0)) + popcount(solid & ~(right ? right[w] : 0));
+                faces += popcount(solid & ~(bottom ? bottom[w] : 0)) + popcount(solid & ~(top   ? top[w]   : 0));
+            }
+        }
+
+    return faces;
+}
+
+size_t OccupancyMask::getMemoryUsage() const
+{
+    return sizeof(OccupancyMask) + m_words.capacity() * sizeof(uint64_t);
+}
@@ -0,0 +1,85 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+#include "blockstorage.h"
+#include "chunklayout.h"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+/*
+    Occupancy mask
+    --------------
+    One bit per block that is set if the block is solid (anything but AIR). The bits
+    of a row (x, y) are packed along z into 64-bit words, bit z & 63 of word z >> 6,
+    so a whole row of a chunk up to 64 blocks deep is a single word.
+
+    That is the layout the face mask kernels work on (see ChunkKernels), snapshots
+    copy the rows they need and the mesher never packs blocks into bits itself.
+    Queries that only care about solid or empty read one bit instead of decoding the
+    palette, and faces can be found for 64 blocks at once with shifts and masks.
+
+    Like the BlockStorage a chunk that is all solid or all empty has no words at all.
+*/
+class OccupancyMask
+{
+public:
+    OccupancyMask(glm::uvec3 size);
+
+    // Every block solid or empty, drops the words
+    void reset(glm::uvec3 size, bool solid = false);
+    // Sets every bit from the blocks
+    void build(const BlockStorage& blocks, const ChunkLayout& layout);
+
+    bool isSolid(int x, int y, int z) const
+    {
+        if (m_words.empty())
+            return m_uniformSolid;
+
+        return (m_words[row(x, y) + (z >> 6)] >> (z & 63)) & 1;
+    }
+
+    void set(int x, int y, int z, bool solid);
+
+    bool isUniform() const;
+    int  getWordsPerRow() const;
+    // The only word of the row at (x, y), for masks at most 64 blocks deep
+    uint64_t getRowWord(int x, int y) const
+    {
+        if (m_words.empty())
+            return m_uniformSolid ? fullRow(m_size.z) : 0;
+
+        return m_words[row(x, y)];
+    }
+
+    // Faces of solid blocks that touch an empty block, the outside of the chunk counts as empty
+    size_t countFaces() const;
+
+    size_t getMemoryUsage() const;
+
+    // The bits of a row of length blocks all set
+    static uint64_t fullRow(int length)
+    {
+        return (length >= 64) ? ~uint64_t(0) : (uint64_t(1) << length) - 1;
+    }
+
+    static int popcount(uint64_t word)
+    {
+    #ifdef _MSC_VER
+        return (int)__popcnt64(word);
+    #else
+        return __builtin_popcountll(word);
+    #endif
+    }
+
+private:
+    std::vector<uint64_t> m_words;
+    glm::ivec3            m_size;
+    int                   m_wordsPerRow;
+    bool                  m_uniformSolid;
+
+    int row(int x, int y) const { return (x * m_size.y + y) * m_wordsPerRow; }
+};
@@ -0,0 +1,254 @@
+#include "regionfile.h"
+
+#include <cstdio>
+#include <cstring>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+RegionFile::RegionFile(const std::string& path, glm::uvec3 chunkSize)
+    : m_path(path)
+    , m_fileSize(0)
+    , m_open(false)
+    , m_map(nullptr)
+    , m_mapSize(0)
+#ifdef _WIN32
+    , m_fileHandle(nullptr)
+    , m_mapHandle(nullptr)
+#endif
+{
+    m_stream.open(m_path, std::ios::in | std::ios::out | std::ios::binary);
+    if (m_stream.is_open())
+        m_open = readHeader(chunkSize);
+    else
+        m_open = create(chunkSize);
+
+    if (!m_open)
+        printf("[RegionFile]: Could not open region file %s\n", m_path.c_str());
+}
+
+RegionFile::~RegionFile()
+{
+    unmap();
+}
+
+bool RegionFile::isOpen() const
+{
+    return m_open;
+}
+
+const uint8_t* RegionFile::read(const ChunkPos& pos, size_t& size)
+{
+    if (!m_open)
+        return nullptr;
+
+    const Entry& entry = m_table[chunkIndex(pos)];
+    if (entry.offset == 0)
+        return nullptr;
+
+    if (m_map == nullptr && !map())
+        return nullptr;
+
+    if ((uint64_t)entry.offset + entry.size > m_mapSize)
+        return nullptr;
+
+    size = entry.size;
+    return m_map + entry.offset;
+}
+
+bool RegionFile::write(const ChunkPos& pos, const std::vector<uint8_t>& data)
+{
+    if (!m_open)
+        return false;
+
+    // The file is about to change, map it again on the next read
+    unmap();
+
+    const int index = chunkIndex(pos);
+    Entry entry = m_table[index];
+
+    // Reuse the old space if the chunk still fits, otherwise append it
+    if (entry.offset == 0 || data.size() > entry.size)
+    {
+        entry.offset = (uint32_t)m_fileSize;
+        m_fileSize += data.size();
+    }
+    entry.size = (uint32_t)data.size();
+
+    m_stream.seekp(entry.offset);
+    m_stream.write((const char*)data.data(), data.size());
+
+    m_stream.seekp(HEADER_SIZE + index * sizeof(Entry));
+    m_stream.write((const char*)&entry, sizeof(Entry));
+    m_stream.flush();
+
+    if (!m_stream.good())
+    {
+        printf("[RegionFile]: Failed writing to %s\n", m_path.c_str());
+        m_stream.clear();
+        return false;
+    }
+
+    m_table[index] = entry;
+    return true;
+}
+
+/**
+ * Desc. Returns the coordinate of the region containing the given chunk
+*/
+ChunkPos RegionFile::regionPos(const ChunkPos& pos)
+{
+    auto floorDiv = [](int64_t a, int64_t b)
+    {
+        return (a >= 0) ? a / b : -((-a + b - 1) / b);
+    };
+
+    return { floorDiv(pos.x, SIZE_XZ), floorDiv(pos.y, SIZE_Y), floorDiv(pos.z, SIZE_XZ) };
+}
+
+std::string RegionFile::fileName(const ChunkPos& pos)
+{
+    ChunkPos region = regionPos(pos);
+    return "r." + std::to_string(region.x) + "." + std::to_string(region.y) + "." + std::to_string(region.z) + ".wxr";
+}
+
+int RegionFile::chunkIndex(const ChunkPos& pos)
+{
+    ChunkPos local = pos - regionPos(pos) * ChunkPos(SIZE_XZ, SIZE_Y, SIZE_XZ);
+    return (int)((local.x * SIZE_Y + local.y) * SIZE_XZ + local.z);
+}
+
+/**
+ * Desc. Writes the header and an empty offset table to a new file
+*/
+bool RegionFile::create(glm::uvec3 chunkSize)
+{
+    {
+        std::ofstream file(m_path, std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!file.is_open())
+            return false;
+
+        uint32_t header[5] = { MAGIC, VERSION, chunkSize.x, chunkSize.y, chunkSize.z };
+        file.write((const char*)header, sizeof(header));
+
+        m_table.assign(CHUNK_COUNT, { 0, 0 });
+        file.write((const char*)m_table.data(), TABLE_SIZE);
+        if (!file.good())
+            return false;
+    }
+
+    m_fileSize = HEADER_SIZE + TABLE_SIZE;
+    m_stream.open(m_path, std::ios::in | std::ios::out | std::ios::binary);
+    return m_stream.is_open();
+}
+
+/**
+ * Desc. Reads the header and the offset table of an existing file
+ *
+ * Note. Fails if the file was saved with a different chunk size
+*/
+bool RegionFile::readHeader(glm::uvec3 chunkSize)
+{
+    if (!map())
+        return false;
+
+    if (m_mapSize < HEADER_SIZE + TABLE_SIZE)
+        return false;
+
+    uint32_t header[5];
+    memcpy(header, m_map, sizeof(header));
+    if (header[0] != MAGIC || header[1] != VERSION || header[2] != chunkSize.x || header[3] != chunkSize.y || header[4] != chunkSize.z)
+        return false;
+
+    m_table.resize(CHUNK_COUNT);
+    memcpy(m_table.data(), m_map + HEADER_SIZE, TABLE_SIZE);
+    m_fileSize = m_mapSize;
+    return true;
+}
+
+bool RegionFile::map()
+{
+    unmap();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(m_path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping == nullptr)
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (view == nullptr)
+    {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+
+    m_fileHandle = file;
+    m_mapHandle = mapping;
+    m_map = (const uint8_t*)view;
+    m_mapSize = (size_t)size.QuadPart;
+#else
+    int fd = open(m_path.c_str(), O_RDONLY);
+    if (fd == -1)
+        return false;
+
+    struct stat info;
+    if (fstat(fd, &info) == -1 || info.st_size == 0)
+    {
+        close(fd);
+        return false;
+    }
+
+    void* view = mmap(nullptr, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    // The mapping keeps its own reference to the file
+    close(fd);
+
+    if (view == MAP_FAILED)
+        return false;
+
+    m_map = (const uint8_t*)view;
+    m_mapSize = (size_t)info.st_size;
+#endif
+
+    return true;
+}
+
+void RegionFile::unmap()
+{
+    if (m_map == nullptr)
+        return;
+
+#ifdef _WIN32
+    UnmapViewOfFile(m_map);
+    CloseHandle((HANDLE)m_mapHandle);
+    CloseHandle((HANDLE)m_fileHandle);
+    m_mapHandle = nullptr;
+    m_fileHandle = nullptr;
+#else
+    munmap((void*)m_map, m_mapSize);
+#endif
+
+    m_map = nullptr;
+    m_mapSize = 0;
+}
@@ -0,0 +1,81 @@
+#pragma once
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+#include "chunkmap.h"
+
+/*
+    Region file
+    -----------
+    Groups SIZE_XZ * SIZE_Y * SIZE_XZ chunks into a single file so we don't end up
+    with one file per chunk.
+
+    Layout
+    - Header: magic "WXRG", version, chunk size (x, y, z)
+    - Offset table: { uint32 offset, uint32 size } for every chunk in the region,
+      an offset of 0 means the chunk isn't saved
+    - Chunk data, appended to the end of the file. A chunk that got smaller is
+      rewritten in place, otherwise its new data is appended
+
+    Reads go through a read only memory mapping of the whole file so loading a chunk
+    is just a page-in of its data plus the decode. Writes go through a stream and
+    invalidate the mapping, it's mapped again on the next read.
+*/
+class RegionFile
+{
+public:
+    static const int SIZE_XZ = 32;
+    static const int SIZE_Y  = 8;
+    static const int CHUNK_COUNT = SIZE_XZ * SIZE_Y * SIZE_XZ;
+
+    RegionFile(const std::string& path, glm::uvec3 chunkSize);
+    ~RegionFile();
+
+    RegionFile(const RegionFile&) = delete;
+    RegionFile& operator=(const RegionFile&) = delete;
+
+    bool isOpen() const;
+
+    // Returns a pointer to the chunks data inside of the mapping or nullptr if the chunk isn't saved
+    // Note. The pointer is only valid until the next write
+    const uint8_t* read(const ChunkPos& pos, size_t& size);
+    bool           write(const ChunkPos& pos, const std::vector<uint8_t>& data);
+
+    static ChunkPos    regionPos(const ChunkPos& pos);
+    static std::string fileName(const ChunkPos& pos);
+
+private:
+    struct Entry
+    {
+        uint32_t offset;
+        uint32_t size;
+    };
+
+    static const uint32_t MAGIC = 0x47525857; // "WXRG"
+    static const uint32_t VERSION = 1;
+    static const size_t   HEADER_SIZE = 5 * sizeof(uint32_t);
+    static const size_t   TABLE_SIZE = CHUNK_COUNT * sizeof(Entry);
+
+    std::string         m_path;
+    std::fstream        m_stream;
+    std::vector<Entry>  m_table;
+    uint64_t            m_fileSize;
+    bool                m_open;
+
+    const uint8_t*      m_map;
+    size_t              m_mapSize;
+#ifdef _WIN32
+    void*               m_fileHandle;
+    void*               m_mapHandle;
+#endif
+
+    static int chunkIndex(const ChunkPos& pos);
+
+    bool create(glm::uvec3 chunkSize);
+    bool readHeader(glm::uvec3 chunkSize);
+
+    bool map();
+    void unmap();
+};
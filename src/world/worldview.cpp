@@ -0,0 +1,116 @@
+#include "worldview.h"
+
+#include <algorithm>
+#include "../util/math.h"
+
+WorldView::WorldView(ChunkManager& manager)
+    : m_manager(manager)
+    , m_size(manager.chunkSize)
+    , m_chunk(nullptr)
+    , m_origin(0, 0, 0)
+    , m_cached(false)
+{
+}
+
+int WorldView::getBlock(int x, int y, int z)
+{
+    // Unsigned compare checks both ends of the cached chunk at once
+    glm::ivec3 local = glm::ivec3(x, y, z) - m_origin;
+    if (!m_cached || (unsigned)local.x >= (unsigned)m_size.x || (unsigned)local.y >= (unsigned)m_size.y || (unsigned)local.z >= (unsigned)m_size.z)
+    {
+        select(x, y, z);
+        local = glm::ivec3(x, y, z) - m_origin;
+    }
+
+    if (m_chunk == nullptr)
+        return -1;
+
+    return m_chunk->getBlockUnchecked(local.x, local.y, local.z);
+}
+
+int WorldView::getBlock(const glm::vec3& position)
+{
+    glm::ivec3 block = glm::floor(position);
+    return getBlock(block.x, block.y, block.z);
+}
+
+bool WorldView::isSolid(int x, int y, int z)
+{
+    glm::ivec3 local = glm::ivec3(x, y, z) - m_origin;
+    if (!m_cached || (unsigned)local.x >= (unsigned)m_size.x || (unsigned)local.y >= (unsigned)m_size.y || (unsigned)local.z >= (unsigned)m_size.z)
+    {
+        select(x, y, z);
+        local = glm::ivec3(x, y, z) - m_origin;
+    }
+
+    return m_chunk != nullptr && m_chunk->isSolidUnchecked(local.x, local.y, local.z);
+}
+
+bool WorldView::isSolid(const glm::vec3& position)
+{
+    glm::ivec3 block = glm::floor(position);
+    return isSolid(block.x, block.y, block.z);
+}
+
+Chunk* WorldView::getChunk(int x, int y, int z)
+{
+    glm::ivec3 local = glm::ivec3(x, y, z) - m_origin;
+    if (!m_cached || (unsigned)local.x >= (unsigned)m_size.x || (unsigned)local.y >= (unsigned)m_size.y || (unsigned)local.z >= (unsigned)m_size.z)
+        select(x, y, z);
+
+    return m_chunk;
+}
+
+void WorldView::getNeighbourhood(int x, int y, int z, int out[27])
+{
+    getRegion({ x - 1, y - 1, z - 1 }, { x + 2, y + 2, z + 2 }, out);
+}
+
+/**
+ * Desc. Reads the box chunk by chunk so every chunk is only looked up once
+*/
+void WorldView::getRegion(const glm::ivec3& min, const glm::ivec3& max, int* out)
+{
+    const glm::ivec3 extent = max - min;
+    if (extent.x <= 0 || extent.y <= 0 || extent.z <= 0)
+        return;
+
+    // Steps from start to the end of its chunk or the end of the box
+    auto spanEnd = [](int start, int end, int size)
+    {
+        return std::min(end, (Math::floorDiv(start, size) + 1) * size);
+    };
+
+    for (int x0 = min.x; x0 < max.x; x0 = spanEnd(x0, max.x, m_size.x))
+        for (int y0 = min.y; y0 < max.y; y0 = spanEnd(y0, max.y, m_size.y))
+            for (int z0 = min.z; z0 < max.z; z0 = spanEnd(z0, max.z, m_size.z))
+            {
+                const glm::ivec3 end(spanEnd(x0, max.x, m_size.x), spanEnd(y0, max.y, m_size.y), spanEnd(z0, max.z, m_size.z));
+
+                select(x0, y0, z0);
+                for (int x = x0; x < end.x; x++)
+                    for (int y = y0; y < end.y; y++)
+                    {
+                        int* row = out + ((x - min.x) * extent.y + (y - min.y)) * extent.z;
+                        for (int z = z0; z < end.z; z++)
+                            row[z - min.z] = (m_chunk == nullptr) ? -1 : m_chunk->getBlockUnchecked(x - m_origin.x, y - m_origin.y, z - m_origin.z);
+                    }
+            }
+}
+
+void WorldView::getColumn(int x, int z, int minY, int maxY, int* out)
+{
+    getRegion({ x, minY, z }, { x + 1, maxY, z + 1 }, out);
+}
+
+/**
+ * Desc. Caches the chunk containing the block, nullptr is cached as well
+ * so reads around an unloaded chunk don't look it up again
+*/
+void WorldView::select(int x, int y, int z)
+{
+    ChunkPos pos = m_manager.toChunkPos(x, y, z);
+    m_chunk = m_manager.getChunk(pos);
+    m_origin = glm::ivec3(pos) * m_size;
+    m_cached = true;
+}
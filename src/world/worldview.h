@@ -0,0 +1,49 @@
+#pragma once
+#include <glm/glm.hpp>
+#include "chunkmanager.h"
+
+/*
+    World view
+    ----------
+    Cursor for reading many blocks by their global(world) position. The chunk of the
+    last read is cached so only reads that cross into another chunk look the chunk up
+    in the ChunkManager, reads inside of the cached chunk skip the divisions, the
+    hash lookup and the bounds checks of ChunkManager::getBlockGlobal().
+
+    The batched reads fill a caller buffer x major, ((x * YSIZE + y) * ZSIZE) + z,
+    going chunk by chunk. Blocks in chunks that aren't loaded read as -1.
+
+    Note. A view is meant to live for one piece of work, chunks can be unloaded by
+    ChunkManager::Update() so don't keep a view across frames
+*/
+class WorldView
+{
+public:
+    WorldView(ChunkManager& manager);
+
+    int getBlock(int x, int y, int z);
+    int getBlock(const glm::vec3& position);
+
+    // Only reads the chunks occupancy mask, blocks in chunks that aren't loaded aren't solid
+    bool isSolid(int x, int y, int z);
+    bool isSolid(const glm::vec3& position);
+
+    Chunk* getChunk(int x, int y, int z);
+
+    // The 3x3x3 blocks around (x, y, z), out[13] is the block itself
+    void getNeighbourhood(int x, int y, int z, int out[27]);
+    // Every block in [min, max), out must hold the volume of the box
+    void getRegion(const glm::ivec3& min, const glm::ivec3& max, int* out);
+    // Blocks minY to maxY - 1 of the column at (x, z)
+    void getColumn(int x, int z, int minY, int maxY, int* out);
+
+private:
+    ChunkManager&   m_manager;
+    glm::ivec3      m_size;
+
+    Chunk*          m_chunk;
+    glm::ivec3      m_origin;
+    bool            m_cached;
+
+    void select(int x, int y, int z);
+};
@@ -0,0 +1,61 @@
+#include "test.h"
+
+#include "../src/world/chunk.h"
+
+TEST(chunk_copy_on_write)
+{
+    Chunk chunk(glm::vec3(0), glm::uvec3(32, 32, 32), nullptr);
+    chunk.setBlockLocal(1, 2, 3, Blocks::STONE);
+
+    BlockSnapshot before = chunk.snapshotBlocks();
+    chunk.setBlockLocal(1, 2, 3, Blocks::PLANKS);
+    chunk.setBlockLocal(4, 5, 6, Blocks::DIRT);
+
+    // The snapshot keeps the blocks it was taken with
+    CHECK(before.get(1, 2, 3) == Blocks::STONE);
+    CHECK(before.get(4, 5, 6) == Blocks::AIR);
+
+    BlockSnapshot after = chunk.snapshotBlocks();
+    CHECK(after.storage != before.storage);
+    CHECK(after.get(1, 2, 3) == Blocks::PLANKS);
+    CHECK(after.get(4, 5, 6) == Blocks::DIRT);
+    CHECK(after.version != before.version);
+
+    // Letting go of the snapshot doesn't make its storage writable again
+    const BlockStorage* released = after.storage.get();
+    std::shared_ptr<const BlockStorage> held = after.storage;
+    after = BlockSnapshot();
+    chunk.setBlockLocal(1, 2, 3, Blocks::LOG);
+    CHECK(held.get() == released);
+    CHECK(held->get(chunk.getLayout().index(1, 2, 3)) == Blocks::PLANKS);
+    CHECK(chunk.getBlockLocal(1, 2, 3) == Blocks::LOG);
+
+    // Taking a mesh snapshot copies the blocks out and doesn't hand out the storage
+    ChunkSnapshot snapshot;
+    chunk.takeSnapshot(snapshot);
+    CHECK(snapshot.get(1, 2, 3) == Blocks::LOG);
+}
+
+TEST(chunk_block_counts)
+{
+    Chunk chunk(glm::vec3(0), glm::uvec3(32, 32, 32), nullptr);
+    CHECK(chunk.isUniform() && chunk.getUniformBlock() == Blocks::AIR);
+    CHECK(chunk.countBlock(Blocks::AIR) == 32 * 32 * 32);
+    CHECK(!chunk.contains(Blocks::LOG));
+    CHECK(!chunk.isAllSolid());
+
+    chunk.fill([](int, int y, int) { return y < 10 ? Blocks::STONE : Blocks::DIRT; });
+    CHECK(chunk.isAllSolid());
+    CHECK(!chunk.contains(Blocks::AIR));
+    CHECK(chunk.countBlock(Blocks::STONE) == 32 * 10 * 32);
+
+    chunk.setBlockLocal(4, 20, 4, Blocks::LOG);
+    chunk.setBlockLocal(5, 20, 4, Blocks::AIR);
+    CHECK(chunk.contains(Blocks::LOG) && chunk.countBlock(Blocks::LOG) == 1);
+    CHECK(!chunk.isAllSolid());
+    CHECK(chunk.countBlock(Blocks::DIRT) == 32 * 22 * 32 - 2);
+
+    // Overwriting the last one drops the type
+    chunk.setBlockLocal(4, 20, 4, Blocks::DIRT);
+    CHECK(!chunk.contains(Blocks::LOG));
+}
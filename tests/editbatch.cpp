@@ -0,0 +1,132 @@
+#include "test.h"
+
+#include "../src/world/chunkmanager.h"
+#include "../src/world/editbatch.h"
+
+namespace
+{
+    void loadWorld(ChunkManager& manager)
+    {
+        manager.setTerrain(32, 96, 5);
+        manager.setStreamingRadius(2, 1);
+        manager.setChunksPerFrame(1000);
+        manager.Update({ 0, 40, 0 });
+    }
+
+    int countBlocks(ChunkManager& manager, const glm::ivec3& min, const glm::ivec3& max, int blockid)
+    {
+        int count = 0;
+        for (int x = min.x; x < max.x; x++)
+            for (int y = min.y; y < max.y; y++)
+                for (int z = min.z; z < max.z; z++)
+                    count += manager.getBlockGlobal(x, y, z) == blockid;
+        return count;
+    }
+
+    std::vector<int> readBlocks(ChunkManager& manager, const glm::ivec3& min, const glm::ivec3& max)
+    {
+        std::vector<int> blocks;
+        for (int x = min.x; x < max.x; x++)
+            for (int y = min.y; y < max.y; y++)
+                for (int z = min.z; z < max.z; z++)
+                    blocks.push_back(manager.getBlockGlobal(x, y, z));
+        return blocks;
+    }
+};
+
+TEST(editbatch_fill)
+{
+    ChunkManager manager;
+    loadWorld(manager);
+
+    // Crosses chunk borders on every axis
+    const glm::ivec3 min(-10, 20, -30), max(40, 40, 5);
+    const std::vector<int> original = readBlocks(manager, min, max);
+    const int stone = countBlocks(manager, min, max, Blocks::STONE);
+
+    // Every block is changed twice in the same batch
+    {
+        EditBatch batch(manager);
+        batch.fillBox(min, max, Blocks::STONE);
+        batch.replace(min, max, Blocks::STONE, Blocks::PLANKS);
+        CHECK(batch.getChanged() > 0);
+    }
+    CHECK(countBlocks(manager, min, max, Blocks::PLANKS) == 50 * 20 * 35);
+    CHECK(manager.getBlockGlobal(min.x - 1, min.y, min.z) != Blocks::PLANKS);
+    CHECK(manager.getBlockGlobal(max.x, max.y - 1, max.z - 1) != Blocks::PLANKS);
+
+    {
+        EditBatch batch(manager);
+        batch.fillSphere({ 0, 30, 0 }, 5, Blocks::AIR);
+    }
+    int sphere = 0;
+    for (int x = -5; x <= 5; x++)
+        for (int y = -5; y <= 5; y++)
+            for (int z = -5; z <= 5; z++)
+                sphere += x * x + y * y + z * z <= 25;
+    CHECK(countBlocks(manager, { -5, 25, -5 }, { 6, 36, 6 }, Blocks::AIR) == sphere);
+
+    // A batch is undone as a whole, newest first
+    CHECK(manager.undo());
+    CHECK(countBlocks(manager, { -5, 25, -5 }, { 6, 36, 6 }, Blocks::AIR) == 0);
+    CHECK(manager.undo());
+    CHECK(readBlocks(manager, min, max) == original);
+    CHECK(countBlocks(manager, min, max, Blocks::STONE) == stone);
+    CHECK(manager.redo());
+    CHECK(countBlocks(manager, min, max, Blocks::PLANKS) == 50 * 20 * 35);
+}
+
+TEST(editbatch_copy_paste)
+{
+    ChunkManager manager;
+    loadWorld(manager);
+
+    const glm::ivec3 min(-20, 10, -20), max(12, 50, 7);
+    BlockVolume volume;
+    EditBatch batch(manager);
+    batch.copy(min, max, volume);
+    CHECK(volume.size == max - min);
+
+    const glm::ivec3 origin(-30, 15, 3);
+    batch.paste(volume, origin);
+    batch.commit();
+
+    int mismatches = 0;
+    for (int x = 0; x < volume.size.x; x++)
+        for (int y = 0; y < volume.size.y; y++)
+            for (int z = 0; z < volume.size.z; z++)
+                mismatches += manager.getBlockGlobal(origin.x + x, origin.y + y, origin.z + z) != volume.blocks[volume.index(x, y, z)];
+    CHECK(mismatches == 0);
+}
+
+// A commit only queues the edited chunks and the neighbours whose border was edited
+TEST(editbatch_dirty_chunks)
+{
+    ChunkManager manager;
+    loadWorld(manager);
+
+    Chunk* chunk = manager.getChunk({ 0, 1, 0 });
+    Chunk* east = chunk->getNeighbour(EAST);
+    Chunk* west = chunk->getNeighbour(WEST);
+    CHECK(!chunk->isDirty() && !east->isDirty() && !west->isDirty());
+
+    {
+        EditBatch batch(manager);
+        batch.fillBox({ 10, 40, 10 }, { 20, 42, 20 }, Blocks::LOG);
+        batch.fillBox({ 12, 41, 12 }, { 14, 43, 14 }, Blocks::LEAF);
+    }
+    CHECK(chunk->isDirty());
+    CHECK(!east->isDirty() && !west->isDirty());
+    CHECK(chunk->getDirtySections() != Chunk::ALL_SECTIONS);
+
+    manager.Update({ 0, 40, 0 });
+    CHECK(!chunk->isDirty());
+
+    // x = 31 is the border to the next chunk along +x
+    {
+        EditBatch batch(manager);
+        batch.setBlock(31, 40, 5, Blocks::SAND);
+    }
+    CHECK(chunk->isDirty());
+    CHECK(chunk->getNeighbour(EAST)->isDirty() != chunk->getNeighbour(WEST)->isDirty());
+}
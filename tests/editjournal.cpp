@@ -0,0 +1,115 @@
+#include "test.h"
+
+#include "../src/world/chunkmanager.h"
+#include "../src/world/editjournal.h"
+
+namespace
+{
+    // One group of count changes in the chunk at (group, 0, 0)
+    void recordGroup(EditJournal& journal, int group, int count)
+    {
+        for (int i = 0; i < count; i++)
+            journal.record({ group, 0, 0 }, { i % 32, i / 32, 0 }, 0, (uint16_t)(group + 1));
+        journal.closeGroup();
+    }
+
+    int groupId(const std::vector<uint8_t>& group)
+    {
+        int id = -1;
+        EditJournal::forEachChange(group, [&](const ChunkPos& pos, const EditJournal::Change&) { id = (int)pos.x; });
+        return id;
+    }
+};
+
+TEST(journal_spill)
+{
+    const std::string path = Test::getDirectory("journal") + "/journal.tmp";
+    EditJournal journal;
+    journal.setSpillFile(path);
+    journal.setMemoryLimit(4096);
+
+    for (int group = 0; group < 20; group++)
+        recordGroup(journal, group, 100);
+    CHECK(journal.getUndoCount() == 20);
+    CHECK(journal.getMemoryUsage() <= sizeof(EditJournal) + 4096);
+
+    // Spilled groups come back newest first
+    std::vector<uint8_t> group;
+    for (int expected = 19; expected >= 0; expected--)
+    {
+        CHECK(journal.popUndo(group));
+        CHECK(groupId(group) == expected);
+        journal.pushRedo(group);
+    }
+    CHECK(!journal.popUndo(group));
+}
+
+// Undoing everything moves it onto the redo stack, which has to stay in the limit too
+TEST(journal_redo_bounded)
+{
+    EditJournal journal;
+    journal.setMemoryLimit(4096);
+
+    for (int group = 0; group < 20; group++)
+        recordGroup(journal, group, 100);
+
+    std::vector<uint8_t> group;
+    while (journal.popUndo(group))
+        journal.pushRedo(group);
+
+    CHECK(journal.getMemoryUsage() <= sizeof(EditJournal) + 4096);
+    CHECK(journal.getRedoCount() > 0);
+    CHECK(journal.getRedoCount() < 20);
+
+    // What's left are the groups that are redone first, oldest first
+    int expected = 20 - (int)journal.getRedoCount();
+    while (journal.popRedo(group))
+    {
+        CHECK(groupId(group) == expected);
+        expected++;
+    }
+    CHECK(expected == 20);
+}
+
+TEST(manager_undo_redo)
+{
+    ChunkManager manager;
+    manager.setStreamingRadius(1, 1);
+    manager.setChunksPerFrame(1000);
+    manager.Update({ 0, 40, 0 });
+
+    const int before = manager.getBlockGlobal(3, 40, 3);
+    manager.setBlockGlobal(3, 40, 3, Blocks::PLANKS);
+    manager.setBlockGlobal(3, 40, 3, Blocks::LOG);
+
+    CHECK(manager.undo());
+    CHECK(manager.getBlockGlobal(3, 40, 3) == Blocks::PLANKS);
+    CHECK(manager.undo());
+    CHECK(manager.getBlockGlobal(3, 40, 3) == before);
+    CHECK(manager.redo());
+    CHECK(manager.getBlockGlobal(3, 40, 3) == Blocks::PLANKS);
+
+    // A new edit can't be redone past
+    manager.setBlockGlobal(3, 41, 3, Blocks::SAND);
+    CHECK(!manager.redo());
+    CHECK(manager.getBlockGlobal(3, 40, 3) == Blocks::PLANKS);
+}
+
+// Writing the block that is already there changes nothing, not even the saved edits
+TEST(manager_same_block)
+{
+    ChunkManager manager;
+    manager.setStreamingRadius(1, 1);
+    manager.setChunksPerFrame(1000);
+    manager.Update({ 0, 40, 0 });
+
+    Chunk* chunk = manager.getChunk(manager.toChunkPos(3, 40, 3));
+    CHECK(chunk != nullptr);
+    const uint32_t version = chunk->getVersion();
+    const size_t undo = manager.journal.getUndoCount();
+
+    manager.setBlockGlobal(3, 40, 3, manager.getBlockGlobal(3, 40, 3));
+    CHECK(chunk->getVersion() == version);
+    CHECK(!chunk->isModified());
+    CHECK(manager.journal.getUndoCount() == undo);
+}
@@ -0,0 +1,54 @@
+#include "test.h"
+
+#include <filesystem>
+#include "../src/world/blocks.h"
+#include "../src/world/chunkmanager.h"
+
+// No GL function was loaded, anything that reaches GL would crash
+TEST(headless_streaming)
+{
+    CHECK(glad_glGenBuffers == nullptr);
+
+    const std::string directory = Test::getDirectory("headless");
+    const glm::vec3 camera(0, 40, 0);
+    {
+        ChunkManager manager;
+        manager.setTerrain(32, 96, 7);
+        manager.setStreamingRadius(2, 1);
+        manager.setChunksPerFrame(1000);
+        manager.openWorld(directory);
+        manager.Update(camera);
+
+        int loaded = 0;
+        int meshes = 0;
+        for (auto chunk : manager.chunks)
+        {
+            loaded++;
+            meshes += chunk->getMesh() != nullptr;
+        }
+        CHECK(loaded > 0);
+        CHECK(meshes == 0);
+
+        manager.setBlockGlobal(1, 40, 1, Blocks::PLANKS);
+        manager.Update(camera);
+        CHECK(manager.getBlockGlobal(1, 40, 1) == Blocks::PLANKS);
+
+        // Moving away unloads (and saves) the chunks we started in
+        for (int x = 32; x <= 320; x += 32)
+            manager.Update({ x, 40, 0 });
+        CHECK(manager.getChunk(manager.toChunkPos(1, 40, 1)) == nullptr);
+    }
+
+    bool regions = false;
+    for (auto& entry : std::filesystem::directory_iterator(directory))
+        regions |= entry.path().extension() == ".wxr";
+    CHECK(regions);
+
+    // A new manager reads the edit back from the save
+    ChunkManager manager;
+    manager.setStreamingRadius(1, 1);
+    manager.setChunksPerFrame(1000);
+    manager.openWorld(directory);
+    manager.Update(camera);
+    CHECK(manager.getBlockGlobal(1, 40, 1) == Blocks::PLANKS);
+}
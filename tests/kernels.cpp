@@ -0,0 +1,91 @@
+#include "test.h"
+
+#include "../src/world/chunkkernels.h"
+#include "../src/world/chunkmanager.h"
+
+namespace
+{
+    // The kernel of the current isa gives the same masks as the generic loop
+    bool kernelMatches(const ChunkSnapshot& snapshot)
+    {
+        ChunkKernels::FaceMaskKernel kernel = ChunkKernels::getFaceMaskKernel(snapshot.size);
+        if (kernel == nullptr || snapshot.rows.empty())
+            return false;
+
+        const int count = snapshot.size.x * snapshot.size.y * snapshot.size.z;
+        std::vector<uint8_t> masks(count), expected(count);
+        kernel(snapshot.blocks.data(), snapshot.rows.data(), masks.data());
+        ChunkKernels::faceMasks(snapshot.size, snapshot.blocks.data(), expected.data());
+        return masks == expected;
+    }
+
+    // Whole chunks and every section, the chunks at the edge have missing neighbours
+    void checkKernels(ChunkManager& manager)
+    {
+        ChunkSnapshot snapshot;
+        const int height = (int)manager.chunkSize.y;
+        for (auto chunk : manager.chunks)
+        {
+            chunk->takeSnapshot(snapshot);
+            CHECK(kernelMatches(snapshot));
+
+            for (int y = 0; y < height; y += Chunk::SECTION_HEIGHT)
+            {
+                chunk->takeSnapshot(snapshot, y, std::min(y + Chunk::SECTION_HEIGHT, height));
+                CHECK(kernelMatches(snapshot));
+            }
+        }
+    }
+};
+
+TEST(kernels_match_generic)
+{
+    ChunkManager manager;
+    manager.setTerrain(32, 96, 13);
+    manager.setStreamingRadius(1, 1, 0);
+    manager.setChunksPerFrame(1000);
+    manager.Update({ 0, 40, 0 });
+
+    // Single blocks and holes at chunk borders so the rows aren't only full or empty
+    for (int x = -2; x < 34; x += 3)
+        for (int z = -2; z < 34; z += 5)
+        {
+            manager.setBlockGlobal(x, 31, z, Blocks::AIR);
+            manager.setBlockGlobal(x, 32, z, Blocks::STONE);
+        }
+
+    const ChunkKernels::Isa isa = ChunkKernels::getIsa();
+    for (ChunkKernels::Isa kernelIsa : { ChunkKernels::Isa::SCALAR, ChunkKernels::Isa::AVX2 })
+    {
+        if (!ChunkKernels::isSupported(kernelIsa))
+        {
+            // Falls back to the fastest one the CPU has
+            ChunkKernels::setIsa(kernelIsa);
+            CHECK(ChunkKernels::getIsa() == isa);
+            continue;
+        }
+
+        ChunkKernels::setIsa(kernelIsa);
+        CHECK(ChunkKernels::getIsa() == kernelIsa);
+        checkKernels(manager);
+    }
+    ChunkKernels::setIsa(isa);
+}
+
+// Rows deeper than a word have no kernel, the snapshot carries no rows for them
+TEST(kernels_deep_chunk)
+{
+    const glm::uvec3 size(16, 16, 128);
+    Chunk chunk(glm::vec3(0), size, nullptr);
+    chunk.setBlockLocal(3, 4, 100, Blocks::STONE);
+
+    ChunkSnapshot snapshot;
+    chunk.takeSnapshot(snapshot);
+    CHECK(snapshot.rows.empty());
+    CHECK(ChunkKernels::getFaceMaskKernel(size) == nullptr);
+
+    Chunk small(glm::vec3(0), glm::uvec3(32), nullptr);
+    small.setBlockLocal(0, 0, 31, Blocks::STONE);
+    small.takeSnapshot(snapshot);
+    CHECK(kernelMatches(snapshot));
+}
@@ -0,0 +1,58 @@
+#include "test.h"
+
+#include <cstring>
+#include <filesystem>
+
+namespace
+{
+    int         failures = 0;
+    std::string root = "build/test_files";
+}
+
+std::vector<Test::Case>& Test::getCases()
+{
+    static std::vector<Case> cases;
+    return cases;
+}
+
+void Test::fail(const char* file, int line, const char* expression)
+{
+    printf("    %s:%d: CHECK(%s) failed\n", file, line, expression);
+    failures++;
+}
+
+std::string Test::getDirectory(const char* name)
+{
+    const std::string directory = root + "/" + name;
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+    return directory;
+}
+
+int main(int argc, char* argv[])
+{
+    int run = 0;
+    int failed = 0;
+    for (const Test::Case& test : Test::getCases())
+    {
+        if (argc > 1 && strstr(test.name, argv[1]) == nullptr)
+            continue;
+
+        const int before = failures;
+        test.run();
+        run++;
+
+        if (failures != before)
+        {
+            printf("FAIL %s\n", test.name);
+            failed++;
+        }
+        else printf("ok   %s\n", test.name);
+    }
+
+    std::error_code error;
+    std::filesystem::remove_all(root, error);
+
+    printf("%d of %d tests passed\n", run - failed, run);
+    return failed == 0 ? 0 : 1;
+}
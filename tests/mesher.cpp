@@ -0,0 +1,75 @@
+#include "test.h"
+
+#include <map>
+#include "../src/world/chunkmanager.h"
+#include "../src/world/chunkmesher.h"
+
+namespace
+{
+    const int ATLAS_TILES = 8;
+
+    // Blocks covered by the quads of every face direction and atlas tile
+    std::map<std::pair<int, int>, int> coverage(const MeshData& mesh)
+    {
+        std::map<std::pair<int, int>, int> area;
+        for (size_t i = 0; i + 3 < mesh.verticies.size(); i += 4)
+        {
+            glm::ivec3 min = ChunkVertex::getPosition(mesh.verticies[i]);
+            glm::ivec3 max = min;
+            for (int v = 1; v < 4; v++)
+            {
+                min = glm::min(min, ChunkVertex::getPosition(mesh.verticies[i + v]));
+                max = glm::max(max, ChunkVertex::getPosition(mesh.verticies[i + v]));
+            }
+
+            // The extent along the normal is 0
+            const glm::ivec3 extent = glm::max(max - min, glm::ivec3(1));
+            const GLuint vertex = mesh.verticies[i];
+            area[{ (int)ChunkVertex::getFace(vertex), ChunkVertex::getTile(vertex) }] += extent.x * extent.y * extent.z;
+        }
+        return area;
+    }
+};
+
+TEST(mesher_greedy_covers_naive)
+{
+    ChunkManager manager;
+    manager.setTerrain(32, 96, 21);
+    manager.setStreamingRadius(1, 1);
+    manager.setChunksPerFrame(1000);
+    manager.Update({ 0, 40, 0 });
+
+    ChunkSnapshot snapshot;
+    MeshData naive, greedy;
+    size_t naiveQuads = 0, greedyQuads = 0;
+    for (auto chunk : manager.chunks)
+    {
+        chunk->takeSnapshot(snapshot);
+        ChunkMesher::build(snapshot, ATLAS_TILES, naive, ChunkMesher::Mode::NAIVE);
+        ChunkMesher::build(snapshot, ATLAS_TILES, greedy, ChunkMesher::Mode::GREEDY);
+
+        CHECK(coverage(naive) == coverage(greedy));
+        naiveQuads += naive.getQuadCount();
+        greedyQuads += greedy.getQuadCount();
+    }
+    CHECK(greedyQuads > 0);
+    CHECK(greedyQuads < naiveQuads);
+}
+
+// Switching the mode remeshes every chunk that has a mesh, headless chunks have none
+TEST(mesher_mode_switch)
+{
+    ChunkManager manager;
+    manager.setStreamingRadius(1, 1);
+    manager.setChunksPerFrame(1000);
+    manager.Update({ 0, 40, 0 });
+
+    const ChunkMesher::Mode mode = ChunkMesher::getMode();
+    manager.setMeshMode(ChunkMesher::Mode::NAIVE);
+    CHECK(ChunkMesher::getMode() == ChunkMesher::Mode::NAIVE);
+    for (auto chunk : manager.chunks)
+        CHECK(!chunk->isDirty());
+
+    manager.setMeshMode(mode);
+    CHECK(ChunkMesher::getMode() == mode);
+}
@@ -0,0 +1,79 @@
+#include "test.h"
+
+#include "../src/world/chunkmanager.h"
+
+namespace
+{
+    // Faces of solid blocks that touch AIR or the outside of the chunk, one block at a time
+    size_t countFacesPerBlock(Chunk& chunk, glm::ivec3 size)
+    {
+        auto solid = [&](int x, int y, int z)
+        {
+            if (x < 0 || y < 0 || z < 0 || x >= size.x || y >= size.y || z >= size.z)
+                return false;
+            return chunk.getBlockLocal(x, y, z) != Blocks::AIR;
+        };
+
+        size_t faces = 0;
+        for (int x = 0; x < size.x; x++)
+            for (int y = 0; y < size.y; y++)
+                for (int z = 0; z < size.z; z++)
+                    if (solid(x, y, z))
+                        faces += !solid(x - 1, y, z) + !solid(x + 1, y, z) + !solid(x, y - 1, z)
+                               + !solid(x, y + 1, z) + !solid(x, y, z - 1) + !solid(x, y, z + 1);
+        return faces;
+    }
+
+    bool maskMatches(Chunk& chunk, glm::ivec3 size)
+    {
+        for (int x = 0; x < size.x; x++)
+            for (int y = 0; y < size.y; y++)
+                for (int z = 0; z < size.z; z++)
+                    if (chunk.isSolidUnchecked(x, y, z) != (chunk.getBlockLocal(x, y, z) != Blocks::AIR))
+                        return false;
+        return true;
+    }
+};
+
+TEST(occupancy_generated)
+{
+    ChunkManager manager;
+    manager.setTerrain(32, 96, 9);
+    manager.setStreamingRadius(1, 1);
+    manager.setChunksPerFrame(1000);
+    manager.Update({ 0, 40, 0 });
+
+    const glm::ivec3 size(manager.chunkSize);
+    int chunks = 0;
+    for (auto chunk : manager.chunks)
+    {
+        CHECK(maskMatches(*chunk, size));
+        CHECK(chunk->getOccupancy().countFaces() == countFacesPerBlock(*chunk, size));
+        chunks++;
+    }
+    CHECK(chunks > 0);
+}
+
+TEST(occupancy_edits)
+{
+    // Columns span two words
+    const glm::ivec3 size(16, 128, 16);
+    Chunk chunk(glm::vec3(0), glm::uvec3(size), nullptr);
+    CHECK(chunk.getOccupancy().isUniform());
+    CHECK(chunk.getOccupancy().countFaces() == 0);
+
+    chunk.fill([](int, int, int) { return Blocks::STONE; });
+    CHECK(maskMatches(chunk, size));
+    CHECK(chunk.getOccupancy().countFaces() == countFacesPerBlock(chunk, size));
+
+    // Holes at the word border and the chunk borders
+    const glm::ivec3 holes[] = { { 3, 63, 3 }, { 3, 64, 3 }, { 0, 0, 0 }, { 15, 127, 15 }, { 7, 30, 0 }, { 8, 31, 9 } };
+    for (auto& hole : holes)
+        chunk.setBlockLocal(hole.x, hole.y, hole.z, Blocks::AIR);
+    CHECK(maskMatches(chunk, size));
+    CHECK(chunk.getOccupancy().countFaces() == countFacesPerBlock(chunk, size));
+
+    chunk.setBlockLocal(3, 64, 3, Blocks::SAND);
+    CHECK(chunk.isSolidUnchecked(3, 64, 3));
+    CHECK(chunk.getOccupancy().countFaces() == countFacesPerBlock(chunk, size));
+}
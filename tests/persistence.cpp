@@ -0,0 +1,254 @@
+#include "test.h"
+
+#include <cstring>
+#include <filesystem>
+#include "../src/world/blocks.h"
+#include "../src/world/chunkmanager.h"
+#include "../src/world/regionfile.h"
+
+namespace
+{
+    const glm::uvec3 CHUNK_SIZE(32, 32, 32);
+
+    std::vector<uint8_t> bytes(size_t count, uint8_t value)
+    {
+        return std::vector<uint8_t>(count, value);
+    }
+
+    bool readEquals(RegionFile& region, const ChunkPos& pos, const std::vector<uint8_t>& expected)
+    {
+        size_t size = 0;
+        const uint8_t* data = region.read(pos, size);
+        return data != nullptr && size == expected.size() && memcmp(data, expected.data(), size) == 0;
+    }
+
+    // Mirrors the save types in ChunkManager, changing them breaks existing saves
+    const uint8_t SAVE_FULL = 0;
+    const uint8_t SAVE_DELTA = 1;
+    const uint8_t SAVE_FULL_MORTON = 2;
+
+    // A few edits in the corners so a wrong layout or offset shows up
+    void paint(Chunk& chunk)
+    {
+        const glm::ivec3 edits[] = { { 0, 0, 0 }, { 31, 0, 0 }, { 0, 31, 0 }, { 0, 0, 31 }, { 5, 17, 29 }, { 31, 31, 31 } };
+        const int blocks[] = { Blocks::STONE, Blocks::PLANKS, Blocks::LOG, Blocks::LEAF, Blocks::GRASS, Blocks::DIRT };
+        for (int i = 0; i < 6; i++)
+        {
+            chunk.setBlockLocal(edits[i].x, edits[i].y, edits[i].z, blocks[i]);
+            chunk.recordEdit(edits[i].x, edits[i].y, edits[i].z, blocks[i]);
+        }
+    }
+
+    // A full save of the chunk with its blocks stored in the given layout
+    std::vector<uint8_t> fullSave(Chunk& chunk, ChunkLayout::Type type, uint8_t saveType)
+    {
+        const ChunkLayout& layout = ChunkLayout::get(CHUNK_SIZE, type);
+        BlockStorage storage(layout.getCount(), Blocks::AIR);
+        for (int i = 0; i < layout.getCount(); i++)
+        {
+            glm::ivec3 p = layout.position(i);
+            storage.set(i, (uint16_t)chunk.getBlockLocal(p.x, p.y, p.z));
+        }
+
+        std::vector<uint8_t> data = { saveType, 0, 0, 0, 0 };
+        storage.serialize(data);
+        uint32_t storageSize = (uint32_t)(data.size() - 5);
+        memcpy(&data[1], &storageSize, sizeof(storageSize));
+
+        chunk.serializeEdits(data);
+        return data;
+    }
+
+    bool sameBlocks(Chunk& a, Chunk& b)
+    {
+        for (int x = 0; x < (int)CHUNK_SIZE.x; x++)
+            for (int y = 0; y < (int)CHUNK_SIZE.y; y++)
+                for (int z = 0; z < (int)CHUNK_SIZE.z; z++)
+                    if (a.getBlockLocal(x, y, z) != b.getBlockLocal(x, y, z))
+                        return false;
+        return true;
+    }
+
+    // Writes data for the chunk at pos straight into the worlds region file
+    bool writeRegion(const std::string& directory, const ChunkPos& pos, const std::vector<uint8_t>& data)
+    {
+        RegionFile region(directory + "/" + RegionFile::fileName(pos), CHUNK_SIZE);
+        return region.write(pos, data);
+    }
+};
+
+TEST(region_write_read)
+{
+    const std::string path = Test::getDirectory("region") + "/r.wxr";
+    const ChunkPos a(0, 0, 0), b(3, 1, 7), missing(1, 0, 0);
+    {
+        RegionFile region(path, CHUNK_SIZE);
+        CHECK(region.isOpen());
+        CHECK(region.write(a, bytes(100, 1)));
+        CHECK(region.write(b, bytes(50, 2)));
+        CHECK(readEquals(region, a, bytes(100, 1)));
+        CHECK(readEquals(region, b, bytes(50, 2)));
+
+        size_t size = 0;
+        CHECK(region.read(missing, size) == nullptr);
+    }
+
+    // Everything is still there after opening the file again
+    RegionFile region(path, CHUNK_SIZE);
+    CHECK(region.isOpen());
+    CHECK(readEquals(region, a, bytes(100, 1)));
+    CHECK(readEquals(region, b, bytes(50, 2)));
+
+    // A region saved with another chunk size can't be used
+    RegionFile other(path, glm::uvec3(16, 16, 16));
+    CHECK(!other.isOpen());
+}
+
+TEST(region_grown_chunk)
+{
+    const std::string path = Test::getDirectory("region_grown") + "/r.wxr";
+    const ChunkPos a(0, 0, 0), b(1, 0, 0);
+    {
+        RegionFile region(path, CHUNK_SIZE);
+        CHECK(region.write(a, bytes(64, 1)));
+        CHECK(region.write(b, bytes(64, 2)));
+
+        // a no longer fits in front of b, it's appended and b stays intact
+        CHECK(region.write(a, bytes(200, 3)));
+        CHECK(readEquals(region, a, bytes(200, 3)));
+        CHECK(readEquals(region, b, bytes(64, 2)));
+
+        // Shrinking reuses the appended space
+        const uintmax_t fileSize = std::filesystem::file_size(path);
+        CHECK(region.write(a, bytes(10, 4)));
+        CHECK(std::filesystem::file_size(path) == fileSize);
+        CHECK(readEquals(region, a, bytes(10, 4)));
+
+        // Growing again has to append after the end and not over b
+        CHECK(region.write(b, bytes(300, 5)));
+        CHECK(readEquals(region, a, bytes(10, 4)));
+        CHECK(readEquals(region, b, bytes(300, 5)));
+    }
+
+    RegionFile region(path, CHUNK_SIZE);
+    CHECK(readEquals(region, a, bytes(10, 4)));
+    CHECK(readEquals(region, b, bytes(300, 5)));
+}
+
+TEST(chunk_serialize)
+{
+    Chunk chunk(glm::vec3(0), CHUNK_SIZE, nullptr);
+    paint(chunk);
+
+    std::vector<uint8_t> data;
+    chunk.serialize(data);
+
+    Chunk loaded(glm::vec3(0), CHUNK_SIZE, nullptr);
+    CHECK(loaded.deserialize(data.data(), data.size()));
+    CHECK(sameBlocks(chunk, loaded));
+    CHECK(loaded.getBlockLocal(5, 17, 29) == Blocks::GRASS);
+
+    // Cut off data is rejected
+    Chunk truncated(glm::vec3(0), CHUNK_SIZE, nullptr);
+    CHECK(!truncated.deserialize(data.data(), 3));
+    CHECK(!truncated.deserialize(data.data(), data.size() / 2));
+}
+
+TEST(load_chunk_data)
+{
+    const std::string directory = Test::getDirectory("load_chunk_data");
+    const ChunkPos pos(2, 1, -3);
+    const glm::vec3 position = glm::vec3(pos) * glm::vec3(CHUNK_SIZE);
+
+    ChunkManager manager;
+    manager.setTerrain(32, 96, 11);
+    manager.openWorld(directory);
+
+    Chunk chunk(position, CHUNK_SIZE, nullptr);
+    manager.generateChunkTerrain(&chunk);
+    paint(chunk);
+
+    // Nothing saved yet
+    Chunk empty(position, CHUNK_SIZE, nullptr);
+    CHECK(!manager.loadChunkData(pos, &empty));
+
+    auto load = [&](const std::vector<uint8_t>& data, bool& loaded)
+    {
+        CHECK(writeRegion(directory, pos, data));
+
+        // Opening the world again drops the managers cached region files
+        manager.openWorld(directory);
+        auto result = std::make_unique<Chunk>(position, CHUNK_SIZE, nullptr);
+        loaded = manager.loadChunkData(pos, result.get());
+        return result;
+    };
+
+    bool loaded = false;
+    auto linear = load(fullSave(chunk, ChunkLayout::LINEAR, SAVE_FULL), loaded);
+    CHECK(loaded);
+    CHECK(sameBlocks(chunk, *linear));
+
+    auto morton = load(fullSave(chunk, ChunkLayout::MORTON, SAVE_FULL_MORTON), loaded);
+    CHECK(loaded);
+    CHECK(sameBlocks(chunk, *morton));
+
+    // Only the edits are saved, the rest is generated again
+    std::vector<uint8_t> delta = { SAVE_DELTA };
+    chunk.serializeEdits(delta);
+    auto edited = load(delta, loaded);
+    CHECK(loaded);
+    CHECK(sameBlocks(chunk, *edited));
+    CHECK(edited->isModified());
+
+    auto unknown = load({ 7, 0, 0, 0, 0 }, loaded);
+    CHECK(!loaded);
+
+    // And what saveChunk() writes for the chunks own layout
+    manager.setSaveMode(SaveMode::FULL);
+    CHECK(manager.saveChunk(pos, &chunk));
+    manager.openWorld(directory);
+    Chunk saved(position, CHUNK_SIZE, nullptr);
+    CHECK(manager.loadChunkData(pos, &saved));
+    CHECK(sameBlocks(chunk, saved));
+}
+
+// A chunk that can't be saved stays loaded until saving works again
+TEST(unload_failed_save)
+{
+    const std::string directory = Test::getDirectory("unload_failed_save");
+    const glm::vec3 camera(0, 40, 0);
+
+    ChunkManager manager;
+    manager.setStreamingRadius(1, 1, 0);
+    manager.setChunksPerFrame(1000);
+    manager.openWorld(directory);
+    manager.Update(camera);
+
+    const ChunkPos pos = manager.toChunkPos(1, 40, 1);
+    manager.setBlockGlobal(1, 40, 1, Blocks::PLANKS);
+
+    // A directory in place of the region file makes every save into it fail
+    const std::string regionPath = directory + "/" + RegionFile::fileName(pos);
+    std::filesystem::create_directory(regionPath);
+
+    const glm::vec3 away(32 * 10, 40, 0);
+    manager.Update(away);
+    CHECK(manager.getChunk(pos) != nullptr);
+    manager.Update(away);
+    CHECK(manager.getChunk(pos) != nullptr);
+
+    // Retried after a wait without moving once the region can be written,
+    // not on every frame
+    std::filesystem::remove(regionPath);
+    int frames = 0;
+    while (manager.getChunk(pos) != nullptr && frames < 1000)
+    {
+        manager.Update(away);
+        frames++;
+    }
+    CHECK(manager.getChunk(pos) == nullptr);
+    CHECK(frames > 1);
+
+    manager.Update(camera);
+    CHECK(manager.getBlockGlobal(1, 40, 1) == Blocks::PLANKS);
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <cstdio>
+#include <string>
+#include <vector>
+
+/*
+    Tests
+    -----
+    Every TEST() registers itself with the runner in main.cpp, a failed CHECK() is
+    reported and the test keeps going so one run shows every broken expectation.
+
+    The tests only link the world code and never create a GL context, GL calls
+    would crash on the unloaded function pointers. Run them with "make test",
+    "make test ARGS=name" only runs the tests whose name contains name.
+*/
+namespace Test
+{
+    struct Case
+    {
+        const char* name;
+        void      (*run)();
+    };
+
+    std::vector<Case>& getCases();
+
+    struct Register
+    {
+        Register(const char* name, void (*run)()) { getCases().push_back({ name, run }); }
+    };
+
+    void fail(const char* file, int line, const char* expression);
+
+    // Empty directory for the files of one test, removed again by the runner
+    std::string getDirectory(const char* name);
+};
+
+#define TEST(name) \
+    static void test_##name(); \
+    static Test::Register register_##name(#name, test_##name); \
+    static void test_##name()
+
+#define CHECK(expression) \
+    do { if (!(expression)) Test::fail(__FILE__, __LINE__, #expression); } while (0)
@@ -0,0 +1,67 @@
+#include "test.h"
+
+#include "../src/world/chunkmanager.h"
+#include "../src/world/worldview.h"
+
+namespace
+{
+    void loadWorld(ChunkManager& manager)
+    {
+        manager.setTerrain(32, 96, 3);
+        manager.setStreamingRadius(1, 1);
+        manager.setChunksPerFrame(1000);
+        manager.Update({ 0, 40, 0 });
+    }
+};
+
+TEST(worldview_reads)
+{
+    ChunkManager manager;
+    loadWorld(manager);
+    WorldView world(manager);
+
+    // Negative coordinates and chunk borders included
+    for (int x = -40; x < 40; x += 3)
+        for (int y = -5; y < 70; y += 2)
+            for (int z = -40; z < 40; z += 5)
+            {
+                CHECK(world.getBlock(x, y, z) == manager.getBlockGlobal(x, y, z));
+                CHECK(world.isSolid(x, y, z) == (manager.getBlockGlobal(x, y, z) > Blocks::AIR));
+            }
+
+    // Chunks that aren't loaded read as -1
+    CHECK(world.getBlock(32 * 20, 0, 0) == -1);
+    CHECK(!world.isSolid(32 * 20, 0, 0));
+}
+
+TEST(worldview_region)
+{
+    ChunkManager manager;
+    loadWorld(manager);
+    WorldView world(manager);
+
+    // Spans chunk borders on every axis and starts at negative positions
+    const glm::ivec3 min(-37, 20, -5), max(3, 45, 40);
+    const glm::ivec3 extent = max - min;
+    std::vector<int> blocks(extent.x * extent.y * extent.z, -2);
+    world.getRegion(min, max, blocks.data());
+
+    int mismatches = 0;
+    int i = 0;
+    for (int x = min.x; x < max.x; x++)
+        for (int y = min.y; y < max.y; y++)
+            for (int z = min.z; z < max.z; z++)
+                mismatches += blocks[i++] != manager.getBlockGlobal(x, y, z);
+    CHECK(mismatches == 0);
+
+    int neighbourhood[27];
+    world.getNeighbourhood(-1, 31, 0, neighbourhood);
+    CHECK(neighbourhood[13] == manager.getBlockGlobal(-1, 31, 0));
+    CHECK(neighbourhood[0] == manager.getBlockGlobal(-2, 30, -1));
+    CHECK(neighbourhood[26] == manager.getBlockGlobal(0, 32, 1));
+
+    int column[64];
+    world.getColumn(-33, 33, -10, 54, column);
+    for (int y = -10; y < 54; y++)
+        CHECK(column[y + 10] == manager.getBlockGlobal(-33, y, 33));
+}